@@ -0,0 +1,575 @@
+#define _GNU_SOURCE // For O_DIRECT
+#include "memory_manager.h"
+#include "linked_list.h"
+#include "unrolled_list.h"
+#include "perf_counters.h"
+#include "mem_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "common_defs.h"
+
+// A benchmark workload: setup and teardown are not measured, run returns the number of operations it timed
+typedef struct {
+    const char* name;
+    const char* description;
+    void (*setup)(size_t n);
+    size_t (*run)(size_t n);
+    void (*teardown)();
+    size_t n;
+    void (*report)();     // Optional extra line printed under the row
+} Workload;
+
+// Shared state between a workload's setup, run and teardown
+static void** blocks = NULL;
+static List list;
+
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// ********* Allocator workloads *********
+
+static void setup_alloc_free(size_t n) {
+    mem_init(n * 16);
+    blocks = malloc(n * sizeof(void*));
+}
+
+/**
+ * @brief Fills the pool with small blocks and frees them again; each mem_alloc scans past all earlier blocks.
+ */
+static size_t run_alloc_free(size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        blocks[i] = mem_alloc(16);
+    }
+    for (size_t i = 0; i < n; i++) {
+        mem_free(blocks[i]);
+    }
+    return 2 * n;
+}
+
+static void teardown_pool() {
+    free(blocks);
+    blocks = NULL;
+    mem_deinit();
+}
+
+static void setup_alloc_fragmented(size_t n) {
+    mem_init(n * 32);
+    blocks = malloc(n * sizeof(void*));
+
+    // Leave a 16-byte hole after every live block; none of the holes fits the timed requests
+    for (size_t i = 0; i < n; i++) {
+        blocks[i] = mem_alloc(16);
+    }
+    for (size_t i = 0; i < n; i += 2) {
+        mem_free(blocks[i]);
+    }
+}
+
+/**
+ * @brief Allocates blocks that only fit past the fragmented region, so every call scans all holes.
+ */
+static size_t run_alloc_fragmented(size_t n) {
+    for (size_t i = 0; i < n / 2; i++) {
+        void* block = mem_alloc(24);
+        if (block == NULL) {
+            return i;
+        }
+    }
+    return n / 2;
+}
+
+// ********* FIFO workloads *********
+
+#define FIFO_WINDOW 256 // Messages in flight at any time
+
+static void setup_fifo_general(size_t n) {
+    mem_init(FIFO_WINDOW * 512);
+    blocks = calloc(FIFO_WINDOW, sizeof(void*));
+}
+
+static void setup_fifo_ring(size_t n) {
+    setup_fifo_general(n);
+    mem_set_ring_mode(true);
+}
+
+/**
+ * @brief Queues messages of varying sizes and frees each one FIFO_WINDOW messages later, like a pipeline stage.
+ */
+static size_t run_fifo(size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        size_t slot = i % FIFO_WINDOW;
+        if (blocks[slot] != NULL) {
+            mem_free(blocks[slot]); // The oldest message leaves the pipeline
+        }
+        blocks[slot] = mem_alloc(16 + (i * 37) % 241);
+        if (blocks[slot] == NULL) {
+            return 2 * i;
+        }
+    }
+    return 2 * n;
+}
+
+static void teardown_fifo() {
+    for (size_t i = 0; i < FIFO_WINDOW; i++) {
+        if (blocks[i] != NULL) {
+            mem_free(blocks[i]);
+        }
+    }
+    teardown_pool();
+}
+
+// ********* Multi-threaded workloads *********
+
+#define MT_THREADS 4
+#define MT_BATCH 32 // Blocks each thread holds before freeing them
+
+static double free_ns_total = 0; // Time spent inside mem_free, summed over all threads
+static size_t free_calls = 0;
+static pthread_mutex_t free_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void setup_mt_sync(size_t n) {
+    mem_init(64 * 1024);
+    mem_set_thread_safe(true);
+    free_ns_total = 0;
+    free_calls = 0;
+}
+
+static void setup_mt_deferred(size_t n) {
+    setup_mt_sync(n);
+    mem_set_deferred_free(true, false);
+}
+
+static void setup_mt_deferred_zero(size_t n) {
+    setup_mt_sync(n);
+    mem_set_deferred_free(true, true);
+}
+
+/**
+ * @brief One thread's share: allocates a batch of blocks, then frees it, timing every mem_free.
+ */
+static void* mt_thread(void* arg) {
+    size_t rounds = *(size_t*)arg / MT_BATCH;
+    void* batch[MT_BATCH];
+    double spent = 0;
+    size_t calls = 0;
+
+    for (size_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < MT_BATCH; i++) {
+            batch[i] = mem_alloc(64 + (r * 31 + i * 17) % 129);
+        }
+        for (size_t i = 0; i < MT_BATCH; i++) {
+            double start = now_ns();
+            mem_free(batch[i]);
+            spent += now_ns() - start;
+            calls++;
+        }
+    }
+
+    pthread_mutex_lock(&free_stats_lock);
+    free_ns_total += spent;
+    free_calls += calls;
+    pthread_mutex_unlock(&free_stats_lock);
+    return NULL;
+}
+
+/**
+ * @brief Runs MT_THREADS threads allocating and freeing n blocks each; queued frees are finished inside the timing.
+ */
+static size_t run_mt(size_t n) {
+    pthread_t threads[MT_THREADS];
+    for (int t = 0; t < MT_THREADS; t++) {
+        pthread_create(&threads[t], NULL, mt_thread, &n);
+    }
+    for (int t = 0; t < MT_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    mem_flush_deferred();
+    return 2 * (n / MT_BATCH * MT_BATCH) * MT_THREADS;
+}
+
+static void teardown_mt() {
+    mem_set_deferred_free(false, false);
+    mem_set_thread_safe(false);
+    mem_deinit();
+}
+
+static void report_free_latency() {
+    if (free_calls > 0) {
+        printf("%-18s mean mem_free latency %.1f ns\n", "", free_ns_total / free_calls);
+    }
+}
+
+// ********* File reading workloads *********
+
+#define IO_FILE "bench_io.dat"       // Created next to the binary; tmpfs would refuse O_DIRECT
+#define IO_CHUNK (256 * 1024)        // Bytes per read call
+
+static char* io_buffer = NULL;
+
+/**
+ * @brief Writes an n MiB file and drops it from the page cache, so both read workloads start cold.
+ */
+static void create_io_file(size_t n) {
+    int fd = open(IO_FILE, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    char* chunk = calloc(1, IO_CHUNK);
+    for (size_t written = 0; fd != -1 && chunk != NULL && written < n * 1024 * 1024; written += IO_CHUNK) {
+        memset(chunk, (int)(written / IO_CHUNK), IO_CHUNK);
+        if (write(fd, chunk, IO_CHUNK) != IO_CHUNK) {
+            break;
+        }
+    }
+    if (fd != -1) {
+        fsync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+    free(chunk);
+}
+
+static void setup_read_buffered(size_t n) {
+    mem_init(4 * IO_CHUNK);
+    create_io_file(n);
+    io_buffer = mem_alloc(IO_CHUNK);
+}
+
+static void setup_read_direct(size_t n) {
+    mem_init(4 * IO_CHUNK);
+    create_io_file(n);
+    io_buffer = mem_alloc_pages(IO_CHUNK / sysconf(_SC_PAGESIZE)); // O_DIRECT needs aligned buffers
+}
+
+/**
+ * @brief Reads the whole file in IO_CHUNK pieces into a pool buffer.
+ */
+static size_t read_file(int flags) {
+    int fd = open(IO_FILE, O_RDONLY | flags);
+    if (fd == -1 || io_buffer == NULL) {
+        return 0; // The file system does not support O_DIRECT, or no buffer
+    }
+    size_t reads = 0;
+    while (read(fd, io_buffer, IO_CHUNK) > 0) {
+        reads++;
+    }
+    close(fd);
+    return reads;
+}
+
+static size_t run_read_buffered(size_t n) {
+    return read_file(0);
+}
+
+static size_t run_read_direct(size_t n) {
+    return read_file(O_DIRECT);
+}
+
+static void teardown_io() {
+    mem_free(io_buffer);
+    io_buffer = NULL;
+    unlink(IO_FILE);
+    teardown_pool();
+}
+
+#define IO_DEPTH 32                  // Blocks read per batch
+#define IO_BLOCK 4096                // Bytes per request
+
+static char* io_blocks[IO_DEPTH];
+static int io_fd = -1;
+
+/**
+ * @brief Pool blocks and an n MiB file already in the page cache, so the reads measure per-request cost.
+ */
+static void setup_small_reads(size_t n) {
+    mem_init(2 * IO_DEPTH * IO_BLOCK);
+    create_io_file(n);
+    io_fd = open(IO_FILE, O_RDONLY);
+    char warm[IO_BLOCK];
+    while (read(io_fd, warm, sizeof(warm)) > 0) {
+        // Bring the file back into the page cache create_io_file dropped it from
+    }
+    for (int i = 0; i < IO_DEPTH; i++) {
+        io_blocks[i] = mem_alloc(IO_BLOCK);
+    }
+}
+
+static void setup_small_reads_uring(size_t n) {
+    setup_small_reads(n);
+    mem_io_init(IO_DEPTH);
+    if (!mem_io_uring_active()) {
+        fprintf(stderr, "io_uring is unavailable; io_uring_fixed measures the pread fallback.\n");
+    }
+}
+
+static size_t run_small_reads_pread(size_t n) {
+    size_t reads = 0;
+    for (off_t offset = 0; offset < (off_t)(n * 1024 * 1024); offset += IO_BLOCK) {
+        if (pread(io_fd, io_blocks[reads % IO_DEPTH], IO_BLOCK, offset) > 0) {
+            reads++;
+        }
+    }
+    return reads;
+}
+
+static size_t run_small_reads_uring(size_t n) {
+    MemIoRequest requests[IO_DEPTH];
+    size_t reads = 0;
+    for (off_t offset = 0; offset < (off_t)(n * 1024 * 1024); offset += IO_DEPTH * IO_BLOCK) {
+        for (int i = 0; i < IO_DEPTH; i++) {
+            requests[i] = (MemIoRequest){.fd = io_fd, .buffer = io_blocks[i], .length = IO_BLOCK, .offset = offset + i * IO_BLOCK};
+        }
+        reads += mem_io_submit(requests, IO_DEPTH);
+    }
+    return reads;
+}
+
+static void teardown_small_reads() {
+    mem_io_deinit();
+    close(io_fd);
+    io_fd = -1;
+    unlink(IO_FILE);
+    teardown_pool();
+}
+
+// ********* Linked list workloads *********
+
+static void setup_list_empty(size_t n) {
+    list_init(&list, sizeof(Node) * n);
+}
+
+static void setup_list_full(size_t n) {
+    list_init(&list, sizeof(Node) * n);
+    for (size_t i = 0; i < n; i++) {
+        list_insert(&list, (uint16_t)i);
+    }
+}
+
+static void setup_list_full_indexed(size_t n) {
+    setup_list_full(n);
+    list_enable_index(&list);
+}
+
+static void setup_list_full_presence(size_t n) {
+    setup_list_full(n);
+    list_enable_presence(&list);
+}
+
+/**
+ * @brief Appends n nodes through the tail pointer.
+ */
+static size_t run_list_insert(size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        list_insert(&list, (uint16_t)i);
+    }
+    return n;
+}
+
+/**
+ * @brief Searches for every value once; each search traverses the list up to the match.
+ */
+static size_t run_list_search(size_t n) {
+    size_t found = 0;
+    for (size_t i = 0; i < n; i++) {
+        found += list_search(&list, (uint16_t)i) != NULL;
+    }
+    return found;
+}
+
+/**
+ * @brief Searches for n values that are not in the list, as a dedup check of new values would.
+ */
+static size_t run_list_search_miss(size_t n) {
+    size_t missed = 0;
+    for (size_t i = 0; i < n; i++) {
+        missed += list_search(&list, (uint16_t)(n + i)) == NULL;
+    }
+    return missed;
+}
+
+static void teardown_list() {
+    list_cleanup(&list);
+}
+
+static UList ulist;
+
+static void setup_ulist_full(size_t n) {
+    ulist_init(&ulist, sizeof(UNode) * (n / ULIST_CAPACITY + 1));
+    for (size_t i = 0; i < n; i++) {
+        ulist_insert(&ulist, (uint16_t)i);
+    }
+}
+
+/**
+ * @brief Same searches as list_search; each node hop covers ULIST_CAPACITY values.
+ */
+static size_t run_ulist_search(size_t n) {
+    size_t found = 0;
+    for (size_t i = 0; i < n; i++) {
+        found += ulist_search(&ulist, (uint16_t)i).node != NULL;
+    }
+    return found;
+}
+
+static void teardown_ulist() {
+    ulist_cleanup(&ulist);
+}
+
+#define SCAN_PASSES 8 // ulist_count_value calls per run, each a full pass over the list
+
+static void setup_ulist_scan(size_t n) {
+    ulist_init(&ulist, sizeof(UNode) * (n / ULIST_CAPACITY + 1));
+    for (size_t i = 0; i < n; i++) {
+        ulist_insert(&ulist, (uint16_t)(i * 40503u));
+    }
+}
+
+static void setup_ulist_scan_scalar(size_t n) {
+    setup_ulist_scan(n);
+    ulist_set_kernel(ULIST_KERNEL_SCALAR);
+}
+
+static void setup_ulist_scan_simd(size_t n) {
+    setup_ulist_scan(n);
+    ulist_set_kernel(ULIST_KERNEL_AUTO);
+}
+
+/**
+ * @brief Counts a few values over the whole list; ops are values compared.
+ */
+static size_t run_ulist_scan(size_t n) {
+    size_t found = 0;
+    for (int pass = 0; pass < SCAN_PASSES; pass++) {
+        found += ulist_count_value(&ulist, (uint16_t)(pass * 977));
+    }
+    return found > 0 ? n * SCAN_PASSES : 0;
+}
+
+static void teardown_ulist_scan() {
+    ulist_set_kernel(ULIST_KERNEL_AUTO);
+    ulist_cleanup(&ulist);
+}
+
+static const Workload workloads[] = {
+    {"alloc_free", "mem_alloc/mem_free of 16-byte blocks", setup_alloc_free, run_alloc_free, teardown_pool, 4000},
+    {"alloc_fragmented", "mem_alloc scanning past 16-byte holes", setup_alloc_fragmented, run_alloc_fragmented, teardown_pool, 4000},
+    {"fifo_general", "FIFO-lifetime messages with first fit", setup_fifo_general, run_fifo, teardown_fifo, 20000},
+    {"fifo_ring", "FIFO-lifetime messages in ring mode", setup_fifo_ring, run_fifo, teardown_fifo, 20000},
+    {"mt_free_sync", "4 threads, mem_free under the pool lock", setup_mt_sync, run_mt, teardown_mt, 20000, report_free_latency},
+    {"mt_free_deferred", "4 threads, frees queued for a background thread", setup_mt_deferred, run_mt, teardown_mt, 20000, report_free_latency},
+    {"mt_free_zero", "As above, freed memory zeroed by that thread", setup_mt_deferred_zero, run_mt, teardown_mt, 20000, report_free_latency},
+    {"read_buffered", "64 MiB file, read() through the page cache", setup_read_buffered, run_read_buffered, teardown_io, 64},
+    {"read_direct", "64 MiB file, O_DIRECT into mem_alloc_pages buffers", setup_read_direct, run_read_direct, teardown_io, 64},
+    {"io_pread", "4 KiB reads of a cached 16 MiB file, one pread each", setup_small_reads, run_small_reads_pread, teardown_small_reads, 16},
+    {"io_uring_fixed", "As above, batches of 32 READ_FIXED into registered pool blocks", setup_small_reads_uring, run_small_reads_uring, teardown_small_reads, 16},
+    {"list_insert", "list_insert appending to the tail", setup_list_empty, run_list_insert, teardown_list, 4000},
+    {"list_search", "list_search for every value", setup_list_full, run_list_search, teardown_list, 4000},
+    {"list_search_index", "As above, through the value index", setup_list_full_indexed, run_list_search, teardown_list, 4000},
+    {"list_search_64k", "list_search for every value of 65536 nodes", setup_list_full, run_list_search, teardown_list, 65536},
+    {"list_index_64k", "As above, through the value index", setup_list_full_indexed, run_list_search, teardown_list, 65536},
+    {"list_search_miss", "list_search for absent values", setup_list_full, run_list_search_miss, teardown_list, 4000},
+    {"list_presence_miss", "As above, ruled out by the presence bitmap", setup_list_full_presence, run_list_search_miss, teardown_list, 4000},
+    {"ulist_search", "ulist_search for every value of an unrolled list", setup_ulist_full, run_ulist_search, teardown_ulist, 4000},
+    {"ucount_scalar", "ulist_count_value over 1M values, scalar kernel", setup_ulist_scan_scalar, run_ulist_scan, teardown_ulist_scan, 1000000},
+    {"ucount_simd", "As above, fastest SIMD kernel", setup_ulist_scan_simd, run_ulist_scan, teardown_ulist_scan, 1000000},
+    {"ucount_scalar_10m", "ulist_count_value over 10M values, scalar kernel", setup_ulist_scan_scalar, run_ulist_scan, teardown_ulist_scan, 10000000},
+    {"ucount_simd_10m", "As above, fastest SIMD kernel", setup_ulist_scan_simd, run_ulist_scan, teardown_ulist_scan, 10000000},
+};
+
+#define WORKLOAD_COUNT (sizeof(workloads) / sizeof(workloads[0]))
+
+/**
+ * @brief Prints one counter per operation, or n/a when it was not collected.
+ */
+static void print_per_op(const PerfSample* sample, PerfCounterId id, size_t ops) {
+    if (sample->valid[id]) {
+        printf(" %12.2f", (double)sample->values[id] / ops);
+    } else {
+        printf(" %12s", "n/a");
+    }
+}
+
+/**
+ * @brief Runs one workload with counters around the timed part and prints its row.
+ */
+static void run_workload(const Workload* workload, PerfCounters* counters) {
+    // The memory manager reports every operation on stdout; keep that out of the table and the timing
+    FILE* saved_stdout = redirect_stdout_to_null();
+    if (saved_stdout == NULL) {
+        printf("Error: Failed to redirect stdout in run_workload.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    workload->setup(workload->n);
+
+    PerfSample sample;
+    double start = now_ns();
+    perf_counters_start(counters);
+    size_t ops = workload->run(workload->n);
+    perf_counters_stop(counters, &sample);
+    double elapsed = now_ns() - start;
+
+    workload->teardown();
+    restore_stdout_from_null(saved_stdout);
+
+    if (ops == 0) {
+        printf("%-18s %10s\n", workload->name, "no ops");
+        return;
+    }
+
+    printf("%-18s %10zu %10.1f", workload->name, ops, elapsed / ops);
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        print_per_op(&sample, (PerfCounterId)i, ops);
+    }
+    if (sample.valid[PERF_CYCLES] && sample.valid[PERF_INSTRUCTIONS] && sample.values[PERF_CYCLES] > 0) {
+        printf(" %6.2f", (double)sample.values[PERF_INSTRUCTIONS] / sample.values[PERF_CYCLES]);
+    } else {
+        printf(" %6s", "n/a");
+    }
+    printf("\n");
+
+    if (workload->report != NULL) {
+        workload->report();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int selected = argc > 1 ? atoi(argv[1]) : 0;
+    if (selected < 0 || selected > (int)WORKLOAD_COUNT) {
+        printf("Usage: %s [workload]\n", argv[0]);
+        printf("Available workloads:\n");
+        for (size_t i = 0; i < WORKLOAD_COUNT; i++) {
+            printf(" %zu. %s - %s\n", i + 1, workloads[i].name, workloads[i].description);
+        }
+        printf(" 0. Run all workloads\n");
+        return 1;
+    }
+
+    PerfCounters counters;
+    if (perf_counters_open(&counters) == 0) {
+        printf_yellow("Hardware counters unavailable (perf_event_open failed); reporting wall-clock time only.\n");
+    }
+
+    printf("%-18s %10s %10s", "workload", "ops", "ns/op");
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        char column[32];
+        snprintf(column, sizeof(column), "%s/op", perf_counter_name((PerfCounterId)i));
+        printf(" %12s", column);
+    }
+    printf(" %6s\n", "IPC");
+
+    for (size_t i = 0; i < WORKLOAD_COUNT; i++) {
+        if (selected == 0 || selected == (int)i + 1) {
+            run_workload(&workloads[i], &counters);
+        }
+    }
+
+    perf_counters_close(&counters);
+    return 0;
+}
@@ -0,0 +1,403 @@
+#include "doubly_list.h"
+#include "linked_list.h"
+#include "memory_manager.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief Allocates a node from the pool without letting mem_alloc print debug info.
+ *
+ * @param caller Name of the calling function for error messages.
+ * @return Pointer to the new node with its data set, or NULL on failure.
+ */
+static DNode* alloc_node(uint16_t data, const char* caller) {
+    // Hide stdout to prevent mem_alloc from printing debug info
+    FILE* saved_stdout = redirect_stdout_to_null();
+    if (saved_stdout == NULL) {
+        printf("Error: Failed to redirect stdout in %s.\n", caller);
+        return NULL;
+    }
+
+    DNode* node = (DNode*)mem_alloc(sizeof(DNode));
+
+    // Restore stdout after allocation
+    restore_stdout_from_null(saved_stdout);
+
+    if (node == NULL) {
+        printf("Error: Memory allocation failed in %s.\n", caller);
+        return NULL;
+    }
+    node->data = data;
+    node->prev = NULL;
+    node->next = NULL;
+    return node;
+}
+
+/**
+ * @brief Returns a node to the pool without letting mem_free print debug info.
+ */
+static void free_node(DNode* node) {
+    FILE* saved_stdout = redirect_stdout_to_null();
+    mem_free(node);
+    restore_stdout_from_null(saved_stdout);
+}
+
+/**
+ * @brief Detaches a node from its neighbours and the list ends, leaving the node itself intact.
+ */
+static void unlink_node(DList* list, DNode* node) {
+    if (node->prev != NULL) {
+        node->prev->next = node->next;
+    } else {
+        list->head = node->next;
+    }
+    if (node->next != NULL) {
+        node->next->prev = node->prev;
+    } else {
+        list->tail = node->prev;
+    }
+    node->prev = NULL;
+    node->next = NULL;
+    list->count--;
+}
+
+/**
+ * @brief Initializes the list and the memory manager.
+ *
+ * @param list Pointer to the list.
+ * @param size Size of the memory pool in bytes.
+ */
+void dlist_init(DList* list, size_t size) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in dlist_init.\n");
+        exit(EXIT_FAILURE); // Can't proceed without a valid list
+    }
+
+    // Temporarily hide stdout to prevent mem_init from printing debug info
+    FILE* saved_stdout = redirect_stdout_to_null();
+    if (saved_stdout == NULL) {
+        printf("Error: Failed to redirect stdout in dlist_init.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    mem_init(size);
+
+    restore_stdout_from_null(saved_stdout);
+
+    list->head = NULL; // Start with an empty list
+    list->tail = NULL;
+    list->count = 0;
+}
+
+/**
+ * @brief Inserts a new node with the specified data at the end of the list in O(1).
+ *
+ * @param list Pointer to the list.
+ * @param data Data to be inserted into the new node.
+ * @return Pointer to the new node, or NULL on failure.
+ */
+DNode* dlist_insert(DList* list, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in dlist_insert.\n");
+        return NULL;
+    }
+
+    DNode* new_node = alloc_node(data, "dlist_insert");
+    if (new_node == NULL) {
+        return NULL;
+    }
+
+    if (list->tail == NULL) {
+        // If the list is empty, the new node is both ends
+        list->head = new_node;
+    } else {
+        new_node->prev = list->tail;
+        list->tail->next = new_node;
+    }
+    list->tail = new_node;
+    list->count++;
+    return new_node;
+}
+
+/**
+ * @brief Inserts a new node with the specified data immediately after the given node in O(1).
+ *
+ * @param list Pointer to the list holding prev_node.
+ * @param prev_node Pointer to the node after which the new node will be inserted.
+ * @param data Data to be inserted into the new node.
+ * @return Pointer to the new node, or NULL on failure.
+ */
+DNode* dlist_insert_after(DList* list, DNode* prev_node, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in dlist_insert_after.\n");
+        return NULL;
+    }
+
+    if (prev_node == NULL) {
+        printf("Error: prev_node is NULL in dlist_insert_after.\n");
+        return NULL;
+    }
+
+    DNode* new_node = alloc_node(data, "dlist_insert_after");
+    if (new_node == NULL) {
+        return NULL;
+    }
+
+    new_node->prev = prev_node;
+    new_node->next = prev_node->next;
+    if (prev_node->next != NULL) {
+        prev_node->next->prev = new_node;
+    } else {
+        list->tail = new_node; // Inserting after the tail
+    }
+    prev_node->next = new_node;
+    list->count++;
+    return new_node;
+}
+
+/**
+ * @brief Inserts a new node with the specified data immediately before the given node in O(1).
+ *
+ * @param list Pointer to the list holding next_node.
+ * @param next_node Pointer to the node before which the new node will be inserted.
+ * @param data Data to be inserted into the new node.
+ * @return Pointer to the new node, or NULL on failure.
+ */
+DNode* dlist_insert_before(DList* list, DNode* next_node, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in dlist_insert_before.\n");
+        return NULL;
+    }
+
+    if (next_node == NULL) {
+        printf("Error: next_node is NULL in dlist_insert_before.\n");
+        return NULL;
+    }
+
+    DNode* new_node = alloc_node(data, "dlist_insert_before");
+    if (new_node == NULL) {
+        return NULL;
+    }
+
+    new_node->next = next_node;
+    new_node->prev = next_node->prev;
+    if (next_node->prev != NULL) {
+        next_node->prev->next = new_node;
+    } else {
+        list->head = new_node; // Inserting before the head
+    }
+    next_node->prev = new_node;
+    list->count++;
+    return new_node;
+}
+
+/**
+ * @brief Unlinks and frees the given node in O(1).
+ *
+ * @param list Pointer to the list holding the node.
+ * @param node Node to remove.
+ */
+void dlist_remove(DList* list, DNode* node) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in dlist_remove.\n");
+        return;
+    }
+
+    if (node == NULL) {
+        printf("Error: node is NULL in dlist_remove.\n");
+        return;
+    }
+
+    unlink_node(list, node);
+    free_node(node);
+}
+
+/**
+ * @brief Deletes the first node with the specified data from the list.
+ *
+ * @param list Pointer to the list.
+ * @param data Data of the node to be deleted.
+ */
+void dlist_delete(DList* list, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in dlist_delete.\n");
+        return;
+    }
+
+    if (list->head == NULL) {
+        printf("Error: Cannot delete from an empty list.\n");
+        return;
+    }
+
+    DNode* node = dlist_search(list, data);
+    if (node == NULL) {
+        printf("Error: Node with data %u not found in dlist_delete.\n", data);
+        return;
+    }
+
+    unlink_node(list, node);
+    free_node(node);
+}
+
+/**
+ * @brief Moves the given node to the head of the list in O(1), e.g. on an LRU hit.
+ *
+ * @param list Pointer to the list holding the node.
+ * @param node Node to move.
+ */
+void dlist_move_to_front(DList* list, DNode* node) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in dlist_move_to_front.\n");
+        return;
+    }
+
+    if (node == NULL) {
+        printf("Error: node is NULL in dlist_move_to_front.\n");
+        return;
+    }
+
+    if (list->head == node) {
+        return; // Already in front
+    }
+
+    unlink_node(list, node);
+    node->next = list->head;
+    if (list->head != NULL) {
+        list->head->prev = node;
+    } else {
+        list->tail = node; // The node was the only one
+    }
+    list->head = node;
+    list->count++; // unlink_node took the node out of the count
+}
+
+/**
+ * @brief Searches for the first node with the specified data.
+ *
+ * @param list Pointer to the list.
+ * @param data Data to search for.
+ * @return Pointer to the found node, or NULL if not found.
+ */
+DNode* dlist_search(DList* list, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in dlist_search.\n");
+        return NULL;
+    }
+
+    for (DNode* current = list->head; current != NULL; current = current->next) {
+        if (current->data == data) {
+            return current; // Found the node
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Displays all elements in the list.
+ *
+ * @param list Pointer to the list.
+ */
+void dlist_display(DList* list) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in dlist_display.\n");
+        return;
+    }
+
+    dlist_display_range(list, NULL, NULL);
+}
+
+/**
+ * @brief Displays all elements in the list from the tail to the head.
+ *
+ * @param list Pointer to the list.
+ */
+void dlist_display_reverse(DList* list) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in dlist_display_reverse.\n");
+        return;
+    }
+
+    printf("[");
+    for (DNode* current = list->tail; current != NULL; current = current->prev) {
+        printf("%u", current->data);
+        if (current->prev != NULL) {
+            printf(", ");
+        }
+    }
+    printf("]"); // Consistent output formatting
+}
+
+/**
+ * @brief Displays elements in the list between two specified nodes.
+ *
+ * @param list Pointer to the list.
+ * @param start_node Pointer to the starting node (inclusive). If NULL, starts from the head.
+ * @param end_node Pointer to the ending node (inclusive). If NULL, ends at the last node.
+ */
+void dlist_display_range(DList* list, DNode* start_node, DNode* end_node) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in dlist_display_range.\n");
+        return;
+    }
+
+    printf("[");
+    DNode* current = start_node != NULL ? start_node : list->head;
+
+    // Print nodes until we reach end_node
+    while (current != NULL) {
+        printf("%u", current->data);
+        if (current == end_node) {
+            break; // Reached the end of the range
+        }
+        if (current->next != NULL) {
+            printf(", ");
+        }
+        current = current->next;
+    }
+    printf("]"); // Consistent output formatting
+}
+
+/**
+ * @brief Counts the number of nodes in the list in O(1).
+ *
+ * @param list Pointer to the list.
+ * @return The total number of nodes in the list.
+ */
+size_t dlist_count_nodes(DList* list) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in dlist_count_nodes.\n");
+        return 0;
+    }
+
+    return list->count;
+}
+
+/**
+ * @brief Frees all nodes and deinitializes the memory manager.
+ *
+ * @param list Pointer to the list.
+ */
+void dlist_cleanup(DList* list) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in dlist_cleanup.\n");
+        return;
+    }
+
+    DNode* current = list->head;
+    while (current != NULL) {
+        DNode* next = current->next;
+        free_node(current);
+        current = next;
+    }
+
+    list->head = NULL; // Reset both ends
+    list->tail = NULL;
+    list->count = 0;
+
+    // Finally, deinitialize the memory manager
+    FILE* saved_deinit_stdout = redirect_stdout_to_null();
+    mem_deinit();
+    restore_stdout_from_null(saved_deinit_stdout);
+}
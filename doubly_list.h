@@ -0,0 +1,137 @@
+#ifndef DOUBLY_LIST_H
+#define DOUBLY_LIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Node structure for the doubly linked list
+typedef struct DNode {
+    uint16_t data;       // Stores the data as an unsigned 16-bit integer
+    struct DNode* prev;  // Pointer to the previous node, NULL at the head
+    struct DNode* next;  // Pointer to the next node, NULL at the tail
+} DNode;
+
+// Both ends and the length of the list, so appending, walking backwards and counting need no walk
+typedef struct {
+    DNode* head;
+    DNode* tail;
+    size_t count;        // Number of nodes
+} DList;
+
+// Initialization function
+/**
+ * @brief Initializes the list and the memory manager.
+ *
+ * @param list Pointer to the list.
+ * @param size Size of the memory pool in bytes.
+ */
+void dlist_init(DList* list, size_t size);
+
+// Insertion functions
+/**
+ * @brief Inserts a new node with the specified data at the end of the list in O(1).
+ *
+ * @param list Pointer to the list.
+ * @param data Data to be inserted into the new node.
+ * @return Pointer to the new node, or NULL on failure.
+ */
+DNode* dlist_insert(DList* list, uint16_t data);
+
+/**
+ * @brief Inserts a new node with the specified data immediately after the given node in O(1).
+ *
+ * @param list Pointer to the list holding prev_node.
+ * @param prev_node Pointer to the node after which the new node will be inserted.
+ * @param data Data to be inserted into the new node.
+ * @return Pointer to the new node, or NULL on failure.
+ */
+DNode* dlist_insert_after(DList* list, DNode* prev_node, uint16_t data);
+
+/**
+ * @brief Inserts a new node with the specified data immediately before the given node in O(1).
+ *
+ * @param list Pointer to the list holding next_node.
+ * @param next_node Pointer to the node before which the new node will be inserted.
+ * @param data Data to be inserted into the new node.
+ * @return Pointer to the new node, or NULL on failure.
+ */
+DNode* dlist_insert_before(DList* list, DNode* next_node, uint16_t data);
+
+// Deletion functions
+/**
+ * @brief Unlinks and frees the given node in O(1).
+ *
+ * @param list Pointer to the list holding the node.
+ * @param node Node to remove.
+ */
+void dlist_remove(DList* list, DNode* node);
+
+/**
+ * @brief Deletes the first node with the specified data from the list.
+ *
+ * @param list Pointer to the list.
+ * @param data Data of the node to be deleted.
+ */
+void dlist_delete(DList* list, uint16_t data);
+
+// Reordering function
+/**
+ * @brief Moves the given node to the head of the list in O(1), e.g. on an LRU hit.
+ *
+ * @param list Pointer to the list holding the node.
+ * @param node Node to move.
+ */
+void dlist_move_to_front(DList* list, DNode* node);
+
+// Search function
+/**
+ * @brief Searches for the first node with the specified data.
+ *
+ * @param list Pointer to the list.
+ * @param data Data to search for.
+ * @return Pointer to the found node, or NULL if not found.
+ */
+DNode* dlist_search(DList* list, uint16_t data);
+
+// Display functions
+/**
+ * @brief Displays all elements in the list.
+ *
+ * @param list Pointer to the list.
+ */
+void dlist_display(DList* list);
+
+/**
+ * @brief Displays all elements in the list from the tail to the head.
+ *
+ * @param list Pointer to the list.
+ */
+void dlist_display_reverse(DList* list);
+
+/**
+ * @brief Displays elements in the list between two specified nodes.
+ *
+ * @param list Pointer to the list.
+ * @param start_node Pointer to the starting node (inclusive). If NULL, starts from the head.
+ * @param end_node Pointer to the ending node (inclusive). If NULL, ends at the last node.
+ */
+void dlist_display_range(DList* list, DNode* start_node, DNode* end_node);
+
+// Nodes count function
+/**
+ * @brief Counts the number of nodes in the list in O(1).
+ *
+ * @param list Pointer to the list.
+ * @return The total number of nodes in the list.
+ */
+size_t dlist_count_nodes(DList* list);
+
+// Cleanup function
+/**
+ * @brief Frees all nodes and deinitializes the memory manager.
+ *
+ * @param list Pointer to the list.
+ */
+void dlist_cleanup(DList* list);
+
+#endif // DOUBLY_LIST_H
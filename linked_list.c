@@ -1,5 +1,6 @@
 #include "linked_list.h"
 #include "memory_manager.h"
+#include "mem_probes.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -7,6 +8,31 @@
 #include <unistd.h>
 #include <fcntl.h>
 
+// Probe semaphores, see mem_probes.h
+MEM_PROBE_SEMAPHORE(linked_list, insert_entry);
+MEM_PROBE_SEMAPHORE(linked_list, insert_return);
+MEM_PROBE_SEMAPHORE(linked_list, insert_after_entry);
+MEM_PROBE_SEMAPHORE(linked_list, insert_after_return);
+MEM_PROBE_SEMAPHORE(linked_list, insert_before_entry);
+MEM_PROBE_SEMAPHORE(linked_list, insert_before_return);
+MEM_PROBE_SEMAPHORE(linked_list, delete_entry);
+MEM_PROBE_SEMAPHORE(linked_list, delete_return);
+
+#define VALUE_COUNT 65536 // Number of possible uint16_t values
+
+// Which values a list holds. Lookups only read the bitmap, which is small enough to stay
+// in cache; the counts tell inserts and deletes when a bit has to change.
+struct ListPresence {
+    uint64_t bits[VALUE_COUNT / 64]; // Bit set while at least one node carries the value
+    uint32_t count[VALUE_COUNT];     // Number of nodes carrying each value; 2^32 nodes would not fit any pool
+};
+
+// Value index: where the first node carrying each value sits. The predecessor is kept rather
+// than the node itself so that list_delete can unlink in O(1).
+struct ListIndex {
+    Node* before[VALUE_COUNT]; // Node preceding the first one with the value, NULL if that one is the head; stale while the count is 0
+};
+
 /**
  * @brief Redirects stdout to /dev/null to suppress unwanted output.
  *
@@ -72,18 +98,156 @@ void restore_stdout_from_null(FILE* saved_stdout_fp) {
     fclose(saved_stdout_fp); // Close the saved stdout stream
 }
 
+/**
+ * @brief Tells whether the list may hold the specified data: false only if the presence bitmap rules it out.
+ */
+static bool may_contain(const List* list, uint16_t data) {
+    return list->presence == NULL || (list->presence->bits[data / 64] >> (data % 64)) & 1;
+}
+
+/**
+ * @brief Counts one more node with the specified data in the presence bitmap.
+ */
+static void presence_add(ListPresence* presence, uint16_t data) {
+    if (presence->count[data]++ == 0) {
+        presence->bits[data / 64] |= (uint64_t)1 << (data % 64);
+    }
+}
+
+/**
+ * @brief Counts one node less with the specified data, clearing its bit with the last copy.
+ */
+static void presence_remove(ListPresence* presence, uint16_t data) {
+    if (--presence->count[data] == 0) {
+        presence->bits[data / 64] &= ~((uint64_t)1 << (data % 64));
+    }
+}
+
+/**
+ * @brief Returns the first node with the specified data according to the index, or NULL if there is none.
+ */
+static Node* index_first(const List* list, uint16_t data) {
+    if (list->presence->count[data] == 0) {
+        return NULL;
+    }
+    Node* before = list->index->before[data];
+    return before != NULL ? before->next : list->head;
+}
+
+/**
+ * @brief Fills the presence bitmap, and the index if there is one, from the nodes currently in the list.
+ */
+static void lookup_rebuild(List* list) {
+    ListPresence* presence = list->presence;
+    memset(presence, 0, sizeof(*presence));
+
+    Node* prev = NULL;
+    for (Node* current = list->head; current != NULL; current = current->next) {
+        if (presence->count[current->data] == 0 && list->index != NULL) {
+            list->index->before[current->data] = prev;
+        }
+        presence_add(presence, current->data);
+        prev = current;
+    }
+}
+
+/**
+ * @brief Links a node in after prev, or at the head if prev is NULL, keeping the tail, count and lookups up to date.
+ */
+static void link_node(List* list, Node* prev, Node* node) {
+    ListIndex* index = list->index;
+    Node* next = prev != NULL ? prev->next : list->head;
+    Node* first = NULL; // First node with the same data before this insert
+
+    if (index != NULL) {
+        first = index_first(list, node->data);
+        // The index tracks the predecessor of next only if next is the first with its value
+        if (next != NULL && index_first(list, next->data) == next) {
+            index->before[next->data] = node;
+        }
+    }
+
+    node->next = next;
+    if (prev != NULL) {
+        prev->next = node;
+    } else {
+        list->head = node;
+    }
+    if (list->tail == prev) {
+        list->tail = node;
+    }
+    list->count++;
+
+    if (index != NULL) {
+        if (first == NULL) {
+            index->before[node->data] = prev;
+        } else {
+            // The node becomes the first copy only if it was linked in ahead of the old one
+            for (Node* current = next; current != NULL; current = current->next) {
+                if (current == first) {
+                    index->before[node->data] = prev;
+                    break;
+                }
+            }
+        }
+    }
+    if (list->presence != NULL) {
+        presence_add(list->presence, node->data);
+    }
+}
+
+/**
+ * @brief Unlinks a node whose predecessor is prev (NULL for the head), keeping the tail, count and lookups up to date.
+ */
+static void unlink_node(List* list, Node* prev, Node* node) {
+    ListIndex* index = list->index;
+    Node* next = node->next;
+    bool was_first = index != NULL && index_first(list, node->data) == node;
+
+    if (index != NULL && next != NULL && index_first(list, next->data) == next) {
+        index->before[next->data] = prev;
+    }
+
+    if (prev != NULL) {
+        prev->next = next;
+    } else {
+        list->head = next;
+    }
+    if (list->tail == node) {
+        list->tail = prev;
+    }
+    list->count--;
+
+    uint16_t data = node->data;
+    if (list->presence != NULL) {
+        presence_remove(list->presence, data);
+    }
+    if (index != NULL) {
+        if (was_first && list->presence->count[data] > 0) {
+            // The next copy becomes the first; it can only be further down the list
+            Node* before = prev;
+            Node* current = next;
+            while (current->data != data) {
+                before = current;
+                current = current->next;
+            }
+            index->before[data] = before;
+        }
+    }
+}
+
 /**
  * @brief Initializes the linked list and the memory manager.
  *
- * Sets up the memory manager with the given size and initializes the list head.
+ * Sets up the memory manager with the given size and empties the list.
  *
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list.
  * @param size Size of the memory pool in bytes.
  */
-void list_init(Node** head, size_t size) {
-    if (head == NULL) {
-        printf("Error: head pointer is NULL in list_init.\n");
-        exit(EXIT_FAILURE); // Can't proceed without a valid head pointer
+void list_init(List* list, size_t size) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in list_init.\n");
+        exit(EXIT_FAILURE); // Can't proceed without a valid list
     }
 
     // Temporarily hide stdout to prevent mem_init from printing debug info
@@ -99,25 +263,34 @@ void list_init(Node** head, size_t size) {
     // Bring stdout back to normal
     restore_stdout_from_null(saved_stdout);
 
-    *head = NULL; // Start with an empty list
+    // Start with an empty list
+    list->head = NULL;
+    list->tail = NULL;
+    list->count = 0;
+    list->presence = NULL;
+    list->index = NULL;
 }
 
 /**
- * @brief Inserts a new node with the specified data at the end of the list.
+ * @brief Inserts a new node with the specified data at the end of the list in O(1).
  *
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list.
  * @param data Data to be inserted into the new node.
  */
-void list_insert(Node** head, uint16_t data) {
-    if (head == NULL) {
-        printf("Error: head pointer is NULL in list_insert.\n");
+void list_insert(List* list, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in list_insert.\n");
         return;
     }
 
+    uint64_t probe_start = MEM_PROBE_START(linked_list, insert_return);
+    MEM_PROBE1(linked_list, insert_entry, data);
+
     // Hide stdout to prevent mem_alloc from printing debug info
     FILE* saved_stdout = redirect_stdout_to_null();
     if (saved_stdout == NULL) {
         printf("Error: Failed to redirect stdout in list_insert.\n");
+        MEM_PROBE3(linked_list, insert_return, data, NULL, MEM_PROBE_ELAPSED(probe_start));
         return;
     }
 
@@ -129,43 +302,42 @@ void list_insert(Node** head, uint16_t data) {
 
     if (new_node == NULL) {
         printf("Error: Memory allocation failed in list_insert.\n");
+        MEM_PROBE3(linked_list, insert_return, data, NULL, MEM_PROBE_ELAPSED(probe_start));
         return;
     }
 
-    // Set up the new node's data and next pointer
+    // Set up the new node's data and link it after the tail, or as the head of an empty list
     new_node->data = data;
-    new_node->next = NULL;
-
-    if (*head == NULL) {
-        // If the list is empty, the new node becomes the head
-        *head = new_node;
-    } else {
-        // Otherwise, find the last node
-        Node* current = *head;
-        while (current->next != NULL) {
-            current = current->next;
-        }
-        // Link the new node at the end
-        current->next = new_node;
-    }
+    link_node(list, list->tail, new_node);
+    MEM_PROBE3(linked_list, insert_return, data, new_node, MEM_PROBE_ELAPSED(probe_start));
 }
 
 /**
  * @brief Inserts a new node with the specified data immediately after the given node.
  *
+ * @param list Pointer to the list holding prev_node.
  * @param prev_node Pointer to the node after which the new node will be inserted.
  * @param data Data to be inserted into the new node.
  */
-void list_insert_after(Node* prev_node, uint16_t data) {
+void list_insert_after(List* list, Node* prev_node, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in list_insert_after.\n");
+        return;
+    }
+
     if (prev_node == NULL) {
         printf("Error: prev_node is NULL in list_insert_after.\n");
         return;
     }
 
+    uint64_t probe_start = MEM_PROBE_START(linked_list, insert_after_return);
+    MEM_PROBE2(linked_list, insert_after_entry, prev_node, data);
+
     // Hide stdout to prevent mem_alloc from printing debug info
     FILE* saved_stdout = redirect_stdout_to_null();
     if (saved_stdout == NULL) {
         printf("Error: Failed to redirect stdout in list_insert_after.\n");
+        MEM_PROBE3(linked_list, insert_after_return, data, NULL, MEM_PROBE_ELAPSED(probe_start));
         return;
     }
 
@@ -177,25 +349,26 @@ void list_insert_after(Node* prev_node, uint16_t data) {
 
     if (new_node == NULL) {
         printf("Error: Memory allocation failed in list_insert_after.\n");
+        MEM_PROBE3(linked_list, insert_after_return, data, NULL, MEM_PROBE_ELAPSED(probe_start));
         return;
     }
 
     // Set up the new node's data and link it after prev_node
     new_node->data = data;
-    new_node->next = prev_node->next;
-    prev_node->next = new_node;
+    link_node(list, prev_node, new_node);
+    MEM_PROBE3(linked_list, insert_after_return, data, new_node, MEM_PROBE_ELAPSED(probe_start));
 }
 
 /**
  * @brief Inserts a new node with the specified data immediately before the given node.
  *
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list holding next_node.
  * @param next_node Pointer to the node before which the new node will be inserted.
  * @param data Data to be inserted into the new node.
  */
-void list_insert_before(Node** head, Node* next_node, uint16_t data) {
-    if (head == NULL) {
-        printf("Error: head pointer is NULL in list_insert_before.\n");
+void list_insert_before(List* list, Node* next_node, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in list_insert_before.\n");
         return;
     }
 
@@ -204,10 +377,14 @@ void list_insert_before(Node** head, Node* next_node, uint16_t data) {
         return;
     }
 
+    uint64_t probe_start = MEM_PROBE_START(linked_list, insert_before_return);
+    MEM_PROBE2(linked_list, insert_before_entry, next_node, data);
+
     // Hide stdout to prevent mem_alloc from printing debug info
     FILE* saved_stdout = redirect_stdout_to_null();
     if (saved_stdout == NULL) {
         printf("Error: Failed to redirect stdout in list_insert_before.\n");
+        MEM_PROBE3(linked_list, insert_before_return, data, NULL, MEM_PROBE_ELAPSED(probe_start));
         return;
     }
 
@@ -219,19 +396,22 @@ void list_insert_before(Node** head, Node* next_node, uint16_t data) {
 
     if (new_node == NULL) {
         printf("Error: Memory allocation failed in list_insert_before.\n");
+        MEM_PROBE3(linked_list, insert_before_return, data, NULL, MEM_PROBE_ELAPSED(probe_start));
         return;
     }
 
     // Set the new node's data
     new_node->data = data;
 
-    if (*head == next_node) {
-        // If we're inserting before the head, update the head pointer
-        new_node->next = *head;
-        *head = new_node;
+    if (list->head == next_node) {
+        // If we're inserting before the head, the new node becomes the head
+        link_node(list, NULL, new_node);
+    } else if (list->index != NULL && index_first(list, next_node->data) == next_node) {
+        // The index knows the predecessor of the first node with each value
+        link_node(list, list->index->before[next_node->data], new_node);
     } else {
         // Find the node just before next_node
-        Node* current = *head;
+        Node* current = list->head;
         while (current != NULL && current->next != next_node) {
             current = current->next;
         }
@@ -242,74 +422,89 @@ void list_insert_before(Node** head, Node* next_node, uint16_t data) {
             FILE* saved_free_stdout = redirect_stdout_to_null();
             mem_free(new_node);
             restore_stdout_from_null(saved_free_stdout);
+            MEM_PROBE3(linked_list, insert_before_return, data, NULL, MEM_PROBE_ELAPSED(probe_start));
             return;
         }
 
         // Insert the new node between current and next_node
-        current->next = new_node;
-        new_node->next = next_node;
+        link_node(list, current, new_node);
     }
+    MEM_PROBE3(linked_list, insert_before_return, data, new_node, MEM_PROBE_ELAPSED(probe_start));
 }
 
 /**
  * @brief Deletes the first node with the specified data from the list.
  *
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list.
  * @param data Data of the node to be deleted.
  */
-void list_delete(Node** head, uint16_t data) {
-    if (head == NULL) {
-        printf("Error: head pointer is NULL in list_delete.\n");
+void list_delete(List* list, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in list_delete.\n");
         return;
     }
 
-    if (*head == NULL) {
+    if (list->head == NULL) {
         printf("Error: Cannot delete from an empty list.\n");
         return;
     }
 
-    Node* current = *head;
+    uint64_t probe_start = MEM_PROBE_START(linked_list, delete_return);
+    MEM_PROBE1(linked_list, delete_entry, data);
+
+    Node* current = list->head;
     Node* prev = NULL;
 
-    // Search for the node to delete
-    while (current != NULL && current->data != data) {
-        prev = current;
-        current = current->next;
+    if (!may_contain(list, data)) {
+        current = NULL; // The bitmap rules it out; no need to look
+    } else if (list->index != NULL) {
+        // The index holds the node before the first match
+        current = index_first(list, data);
+        prev = list->index->before[data];
+    } else {
+        // Search for the node to delete
+        while (current != NULL && current->data != data) {
+            prev = current;
+            current = current->next;
+        }
     }
 
     if (current == NULL) {
         printf("Error: Node with data %u not found in list_delete.\n", data);
+        MEM_PROBE3(linked_list, delete_return, data, NULL, MEM_PROBE_ELAPSED(probe_start));
         return;
     }
 
-    if (prev == NULL) {
-        // If the node to delete is the head, update the head pointer
-        *head = current->next;
-    } else {
-        // Otherwise, unlink the node from the list
-        prev->next = current->next;
-    }
+    unlink_node(list, prev, current);
 
     // Hide stdout to prevent mem_free from printing debug info
     FILE* saved_stdout = redirect_stdout_to_null();
     mem_free(current); // Free the memory of the deleted node
     restore_stdout_from_null(saved_stdout);
+    MEM_PROBE3(linked_list, delete_return, data, current, MEM_PROBE_ELAPSED(probe_start));
 }
 
 /**
  * @brief Searches for the first node with the specified data.
  *
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list.
  * @param data Data to search for.
  * @return Pointer to the found node, or NULL if not found.
  */
-Node* list_search(Node** head, uint16_t data) {
-    if (head == NULL) {
-        printf("Error: head pointer is NULL in list_search.\n");
+Node* list_search(List* list, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in list_search.\n");
         return NULL;
     }
 
-    Node* current = *head;
+    if (!may_contain(list, data)) {
+        return NULL; // Absent values need no walk
+    }
+    if (list->index != NULL) {
+        return index_first(list, data);
+    }
+
+    Node* current = list->head;
 
     // Look through the list for the data
     while (current != NULL) {
@@ -323,19 +518,102 @@ Node* list_search(Node** head, uint16_t data) {
     return NULL;
 }
 
+/**
+ * @brief Tracks which values the list holds, so searching for or deleting an absent value is O(1).
+ *
+ * @param list Pointer to the list.
+ * @return true if the bitmap is in place, false if it could not be allocated.
+ */
+bool list_enable_presence(List* list) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in list_enable_presence.\n");
+        return false;
+    }
+
+    if (list->presence == NULL) {
+        list->presence = malloc(sizeof(ListPresence));
+        if (list->presence == NULL) {
+            printf("Error: Memory allocation failed in list_enable_presence.\n");
+            return false;
+        }
+        lookup_rebuild(list);
+    }
+    return true;
+}
+
+/**
+ * @brief Frees the presence bitmap, and the value index, which depends on it.
+ *
+ * @param list Pointer to the list.
+ */
+void list_disable_presence(List* list) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in list_disable_presence.\n");
+        return;
+    }
+
+    list_disable_index(list);
+    free(list->presence);
+    list->presence = NULL;
+}
+
+/**
+ * @brief Builds a value index so list_search and list_delete find a value without walking the list.
+ *
+ * @param list Pointer to the list.
+ * @return true if the index is in place, false if it could not be allocated.
+ */
+bool list_enable_index(List* list) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in list_enable_index.\n");
+        return false;
+    }
+
+    if (list->index != NULL) {
+        return true;
+    }
+
+    // The index relies on the per-value counts kept with the bitmap
+    if (!list_enable_presence(list)) {
+        return false;
+    }
+    list->index = malloc(sizeof(ListIndex));
+    if (list->index == NULL) {
+        printf("Error: Memory allocation failed in list_enable_index.\n");
+        return false;
+    }
+    lookup_rebuild(list);
+    return true;
+}
+
+/**
+ * @brief Frees the value index; searches walk the list again.
+ *
+ * @param list Pointer to the list.
+ */
+void list_disable_index(List* list) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in list_disable_index.\n");
+        return;
+    }
+
+    free(list->index);
+    list->index = NULL;
+}
+
 /**
  * @brief Displays all elements in the linked list.
  *
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list.
  */
-void list_display(Node** head) {
-    if (head == NULL) {
-        printf("Error: head pointer is NULL in list_display.\n");
+void list_display(List* list) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in list_display.\n");
         return;
     }
 
     printf("[");
-    Node* current = *head;
+    Node* current = list->head;
     while (current != NULL) {
         printf("%u", current->data);
         if (current->next != NULL) {
@@ -349,18 +627,18 @@ void list_display(Node** head) {
 /**
  * @brief Displays elements in the linked list between two specified nodes.
  *
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list.
  * @param start_node Pointer to the starting node (inclusive). If NULL, starts from the head.
  * @param end_node Pointer to the ending node (inclusive). If NULL, ends at the last node.
  */
-void list_display_range(Node** head, Node* start_node, Node* end_node) {
-    if (head == NULL) {
-        printf("Error: head pointer is NULL in list_display_range.\n");
+void list_display_range(List* list, Node* start_node, Node* end_node) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in list_display_range.\n");
         return;
     }
 
     printf("[");
-    Node* current = *head;
+    Node* current = list->head;
 
     // If a start_node is provided, find it first
     if (start_node != NULL) {
@@ -388,41 +666,79 @@ void list_display_range(Node** head, Node* start_node, Node* end_node) {
 }
 
 /**
- * @brief Counts the number of nodes in the linked list.
+ * @brief Counts the number of nodes in the linked list in O(1).
  *
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list.
  * @return The total number of nodes in the list.
  */
-int list_count_nodes(Node** head) {
-    if (head == NULL) {
-        printf("Error: head pointer is NULL in list_count_nodes.\n");
+size_t list_count_nodes(List* list) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in list_count_nodes.\n");
         return 0;
     }
 
-    int count = 0;
-    Node* current = *head;
+    return list->count;
+}
 
-    // Simply traverse the list and count nodes
-    while (current != NULL) {
-        count++;
-        current = current->next;
+/**
+ * @brief Frees every pool block that none of the given lists can reach.
+ *
+ * Runs a mark-sweep cycle of the memory manager with the list heads as roots,
+ * then walks each list once to bring its tail and count back in line.
+ *
+ * @param lists Array of lists.
+ * @param count Number of lists in the array.
+ * @return Number of bytes returned to the pool.
+ */
+size_t list_reclaim(List* lists, size_t count) {
+    if (lists == NULL) {
+        printf("Error: lists pointer is NULL in list_reclaim.\n");
+        return 0;
+    }
+
+    void** roots = malloc((count > 0 ? count : 1) * sizeof(void*));
+    if (roots == NULL) {
+        printf("Error: Memory allocation failed in list_reclaim.\n");
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        roots[i] = lists[i].head;
+    }
+
+    // Hide stdout to prevent the collector from printing debug info
+    FILE* saved_stdout = redirect_stdout_to_null();
+    size_t reclaimed = mem_gc_collect(roots, count);
+    restore_stdout_from_null(saved_stdout);
+    free(roots);
+
+    // The lost nodes were counted when they were inserted
+    for (size_t i = 0; i < count; i++) {
+        lists[i].tail = NULL;
+        lists[i].count = 0;
+        for (Node* current = lists[i].head; current != NULL; current = current->next) {
+            lists[i].tail = current;
+            lists[i].count++;
+        }
+        if (lists[i].presence != NULL) {
+            lookup_rebuild(&lists[i]);
+        }
     }
 
-    return count;
+    return reclaimed;
 }
 
 /**
  * @brief Cleans up the linked list by freeing all nodes and deinitializing the memory manager.
  *
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list.
  */
-void list_cleanup(Node** head) {
-    if (head == NULL) {
-        printf("Error: head pointer is NULL in list_cleanup.\n");
+void list_cleanup(List* list) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in list_cleanup.\n");
         return;
     }
 
-    Node* current = *head;
+    Node* current = list->head;
     while (current != NULL) {
         Node* temp = current;
         current = current->next;
@@ -433,7 +749,11 @@ void list_cleanup(Node** head) {
         restore_stdout_from_null(saved_stdout);
     }
 
-    *head = NULL; // Reset the head pointer
+    // Reset the list to empty
+    list->head = NULL;
+    list->tail = NULL;
+    list->count = 0;
+    list_disable_presence(list);
 
     // Finally, deinitialize the memory manager
     FILE* saved_deinit_stdout = redirect_stdout_to_null();
@@ -1,8 +1,10 @@
 #ifndef LINKED_LIST_H
 #define LINKED_LIST_H
 
+#include <stdio.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 // Node structure for the singly linked list
 typedef struct Node {
@@ -10,94 +12,178 @@ typedef struct Node {
     struct Node* next;   // Pointer to the next node in the list
 } Node;
 
+// Per-value lookup tables of a list, defined in linked_list.c
+typedef struct ListPresence ListPresence;
+typedef struct ListIndex ListIndex;
+
+// Handle of a list: both ends and the length, so appending and counting need no walk
+typedef struct {
+    Node* head;          // First node, NULL for an empty list
+    Node* tail;          // Last node, NULL for an empty list
+    size_t count;        // Number of nodes
+    ListPresence* presence; // Optional presence bitmap, NULL unless list_enable_presence was called
+    ListIndex* index;    // Optional value index, NULL unless list_enable_index was called
+} List;
+
+// Output helpers
+/**
+ * @brief Redirects stdout to /dev/null to suppress unwanted output.
+ *
+ * @return FILE* pointing to the original stdout before redirection, or NULL on failure.
+ */
+FILE* redirect_stdout_to_null();
+
+/**
+ * @brief Restores stdout from a previously saved FILE* stream.
+ *
+ * @param saved_stdout_fp FILE* pointing to the original stdout.
+ */
+void restore_stdout_from_null(FILE* saved_stdout_fp);
+
 // Initialization function
 /**
  * @brief Initializes the linked list and the memory manager.
  *
- * This function initializes the memory manager with a specified size and sets the head of the list to NULL.
+ * This function initializes the memory manager with a specified size and empties the list.
  *
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list.
  * @param size Size of the memory pool in bytes.
  */
-void list_init(Node** head, size_t size);
+void list_init(List* list, size_t size);
 
 // Insertion functions
 /**
- * @brief Inserts a new node with the specified data at the end of the list.
+ * @brief Inserts a new node with the specified data at the end of the list in O(1).
  *
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list.
  * @param data Data to be inserted into the new node.
  */
-void list_insert(Node** head, uint16_t data);
+void list_insert(List* list, uint16_t data);
 
 /**
  * @brief Inserts a new node with the specified data immediately after the given node.
  *
+ * @param list Pointer to the list holding prev_node.
  * @param prev_node Pointer to the node after which the new node will be inserted.
  * @param data Data to be inserted into the new node.
  */
-void list_insert_after(Node* prev_node, uint16_t data);
+void list_insert_after(List* list, Node* prev_node, uint16_t data);
 
 /**
  * @brief Inserts a new node with the specified data immediately before the given node.
  *
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list holding next_node.
  * @param next_node Pointer to the node before which the new node will be inserted.
  * @param data Data to be inserted into the new node.
  */
-void list_insert_before(Node** head, Node* next_node, uint16_t data);
+void list_insert_before(List* list, Node* next_node, uint16_t data);
 
 // Deletion function
 /**
  * @brief Deletes the first node with the specified data from the list.
  *
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list.
  * @param data Data of the node to be deleted.
  */
-void list_delete(Node** head, uint16_t data);
+void list_delete(List* list, uint16_t data);
 
 // Search function
 /**
  * @brief Searches for the first node with the specified data.
  *
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list.
  * @param data Data to search for.
  * @return Pointer to the found node, or NULL if not found.
  */
-Node* list_search(Node** head, uint16_t data);
+Node* list_search(List* list, uint16_t data);
+
+// Value lookup functions
+/**
+ * @brief Tracks which values the list holds, so searching for or deleting an absent value is O(1).
+ *
+ * Keeps an 8 KiB bitmap with one bit per uint16_t value, checked before any walk, and a 32-bit
+ * count per value to know when a delete removes the last copy: 264 KiB in all, from the heap
+ * rather than the pool.
+ *
+ * @param list Pointer to the list.
+ * @return true if the bitmap is in place, false if it could not be allocated.
+ */
+bool list_enable_presence(List* list);
+
+/**
+ * @brief Frees the presence bitmap, and the value index, which depends on it.
+ *
+ * @param list Pointer to the list.
+ */
+void list_disable_presence(List* list);
+
+/**
+ * @brief Builds a value index so list_search and list_delete find a value without walking the list.
+ *
+ * The index has one bucket per uint16_t value (512 KiB, from the heap rather than the pool)
+ * and is kept up to date by every insert and delete. It enables the presence bitmap too.
+ * Appending is O(1), and so are searching for and deleting a value stored only once. With
+ * duplicates, inserting a copy mid-list or deleting the first copy walks to the next copy,
+ * so the first occurrence is still the one found.
+ *
+ * @param list Pointer to the list.
+ * @return true if the index is in place, false if it could not be allocated.
+ */
+bool list_enable_index(List* list);
+
+/**
+ * @brief Frees the value index; searches walk the list again.
+ *
+ * @param list Pointer to the list.
+ */
+void list_disable_index(List* list);
 
 // Display functions
 /**
  * @brief Displays all elements in the linked list.
  *
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list.
  */
-void list_display(Node** head);
+void list_display(List* list);
 
 /**
  * @brief Displays elements in the linked list between two specified nodes.
  *
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list.
  * @param start_node Pointer to the starting node (inclusive). If NULL, starts from the head.
  * @param end_node Pointer to the ending node (inclusive). If NULL, ends at the last node.
  */
-void list_display_range(Node** head, Node* start_node, Node* end_node);
+void list_display_range(List* list, Node* start_node, Node* end_node);
 
 // Nodes count function
 /**
- * @brief Counts the number of nodes in the linked list.
+ * @brief Counts the number of nodes in the linked list in O(1).
  *
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list.
  * @return The total number of nodes in the list.
  */
-int list_count_nodes(Node** head);
+size_t list_count_nodes(List* list);
+
+// Reclamation function
+/**
+ * @brief Frees every pool block that none of the given lists can reach.
+ *
+ * Recovers nodes that were unlinked without being freed, e.g. on an error path,
+ * and recounts the lists. Every list still in use must be passed, or its nodes
+ * are freed too.
+ *
+ * @param lists Array of lists.
+ * @param count Number of lists in the array.
+ * @return Number of bytes returned to the pool.
+ */
+size_t list_reclaim(List* lists, size_t count);
 
 // Cleanup function
 /**
  * @brief Cleans up the linked list by freeing all nodes and deinitializing the memory manager.
  *
- * @param head Pointer to the head of the linked list.
+ * @param list Pointer to the list.
  */
-void list_cleanup(Node** head);
+void list_cleanup(List* list);
 
 #endif // LINKED_LIST_H
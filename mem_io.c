@@ -0,0 +1,437 @@
+#include "mem_io.h"
+#include "memory_manager.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+
+// The raw system calls are used, so the library needs no liburing
+#if defined(__has_include) && !defined(MEM_NO_IO_URING)
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define MEM_IO_URING 1
+#endif
+#endif
+
+#define MAX_FIXED_BUFFER (1UL << 30) // The kernel caps one registered buffer at 1 GiB
+
+// Global Variables
+static pthread_mutex_t io_lock = PTHREAD_MUTEX_INITIALIZER; // Serializes use of the ring
+static _Atomic bool pool_remapped = false;  // Pool pages were remapped since the buffers were registered
+
+#ifdef MEM_IO_URING
+
+// The rings shared with the kernel
+typedef struct {
+    int fd;                       // -1 while no ring is set up
+    unsigned entries;             // Submission queue size, the largest batch
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void* sq_map;
+    size_t sq_map_size;
+    void* cq_map;                 // Same as sq_map when the kernel maps both rings at once
+    size_t cq_map_size;
+    size_t sqes_size;
+    char* registered_base;        // Pool registered as fixed buffers, NULL if registration failed
+    size_t registered_size;
+} IoRing;
+
+static IoRing ring = {.fd = -1};
+
+/**
+ * @brief Unmaps the rings and closes the ring, which also drops the buffer registration.
+ */
+static void ring_close() {
+    if (ring.sqes != NULL) {
+        munmap(ring.sqes, ring.sqes_size);
+    }
+    if (ring.cq_map != NULL && ring.cq_map != ring.sq_map) {
+        munmap(ring.cq_map, ring.cq_map_size);
+    }
+    if (ring.sq_map != NULL) {
+        munmap(ring.sq_map, ring.sq_map_size);
+    }
+    if (ring.fd != -1) {
+        close(ring.fd);
+    }
+    memset(&ring, 0, sizeof(ring));
+    ring.fd = -1;
+}
+
+/**
+ * @brief Creates the ring and maps its queues.
+ *
+ * @return true on success; false leaves no ring behind.
+ */
+static bool ring_open(unsigned queue_depth) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring.fd = (int)syscall(__NR_io_uring_setup, queue_depth, &params);
+    if (ring.fd < 0) {
+        ring.fd = -1;
+        return false;
+    }
+
+    ring.entries = params.sq_entries;
+    ring.sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring.cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_map = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_map && ring.cq_map_size > ring.sq_map_size) {
+        ring.sq_map_size = ring.cq_map_size;
+    }
+
+    ring.sq_map = mmap(NULL, ring.sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING);
+    if (ring.sq_map == MAP_FAILED) {
+        ring.sq_map = NULL;
+        ring_close();
+        return false;
+    }
+    if (single_map) {
+        ring.cq_map = ring.sq_map;
+    } else {
+        ring.cq_map = mmap(NULL, ring.cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING);
+        if (ring.cq_map == MAP_FAILED) {
+            ring.cq_map = NULL;
+            ring_close();
+            return false;
+        }
+    }
+    ring.sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring.sqes = mmap(NULL, ring.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+    if (ring.sqes == MAP_FAILED) {
+        ring.sqes = NULL;
+        ring_close();
+        return false;
+    }
+
+    char* sq = ring.sq_map;
+    char* cq = ring.cq_map;
+    ring.sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring.sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring.sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring.cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring.cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring.cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring.cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return true;
+}
+
+/**
+ * @brief Registers the current pool as fixed buffers, one per GiB.
+ *
+ * Failure (e.g. RLIMIT_MEMLOCK too low) is not an error: requests then use the unregistered opcodes.
+ */
+static void ring_register_pool() {
+    size_t pool_size = mem_pool_size();
+    char* base = mem_from_offset(0);
+    if (base == NULL || pool_size == 0) {
+        return;
+    }
+
+    size_t count = (pool_size + MAX_FIXED_BUFFER - 1) / MAX_FIXED_BUFFER;
+    struct iovec* iovecs = malloc(count * sizeof(struct iovec));
+    if (iovecs == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        size_t start = i * MAX_FIXED_BUFFER;
+        iovecs[i].iov_base = base + start;
+        iovecs[i].iov_len = pool_size - start < MAX_FIXED_BUFFER ? pool_size - start : MAX_FIXED_BUFFER;
+    }
+    if (syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_BUFFERS, iovecs, (unsigned)count) == 0) {
+        ring.registered_base = base;
+        ring.registered_size = pool_size;
+    }
+    free(iovecs);
+}
+
+/**
+ * @brief Registers the pool again after pages were remapped, so fixed requests reach the pages mapped now.
+ */
+static void ring_renew_registration() {
+    if (ring.registered_base != NULL) {
+        syscall(__NR_io_uring_register, ring.fd, IORING_UNREGISTER_BUFFERS, NULL, 0);
+        ring.registered_base = NULL;
+        ring.registered_size = 0;
+    }
+    ring_register_pool();
+}
+
+/**
+ * @brief Finds the registered buffer holding a whole request.
+ *
+ * @return Index of the fixed buffer, or -1 if the request must use an unregistered opcode.
+ */
+static int fixed_buffer_of(const MemIoRequest* request) {
+    // A pool torn down since mem_io_init is no longer what the kernel has pinned
+    if (ring.registered_base == NULL || ring.registered_base != mem_from_offset(0)) {
+        return -1;
+    }
+    const char* buffer = request->buffer;
+    if (buffer < ring.registered_base || request->length > ring.registered_size ||
+        (size_t)(buffer - ring.registered_base) > ring.registered_size - request->length) {
+        return -1;
+    }
+    size_t first = (size_t)(buffer - ring.registered_base);
+    size_t last = request->length > 0 ? first + request->length - 1 : first;
+    if (first / MAX_FIXED_BUFFER != last / MAX_FIXED_BUFFER) {
+        return -1;
+    }
+    return (int)(first / MAX_FIXED_BUFFER);
+}
+
+/**
+ * @brief Copies the results of the completions waiting in the completion queue.
+ *
+ * @return Number of completions reaped.
+ */
+static unsigned ring_reap(MemIoRequest* requests, bool* done) {
+    unsigned reaped = 0;
+    unsigned head = *ring.cq_head;
+    unsigned cq_tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+    while (head != cq_tail) {
+        struct io_uring_cqe* cqe = &ring.cqes[head & *ring.cq_mask];
+        requests[cqe->user_data].result = cqe->res;
+        done[cqe->user_data] = true;
+        reaped++;
+        head++;
+    }
+    __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+    return reaped;
+}
+
+/**
+ * @brief Submits up to ring.entries requests and waits for all of them.
+ *
+ * Requests too long for one queue entry are skipped. If the ring fails, the
+ * requests the kernel already took are waited for, so only the ones it never
+ * saw are left for the fallback and no request runs twice.
+ *
+ * @param done Set for every request the ring took care of; the others need the fallback.
+ * @return false if the ring failed.
+ */
+static bool ring_submit_batch(MemIoRequest* requests, unsigned count, bool* done) {
+    unsigned mask = *ring.sq_mask;
+    unsigned tail = *ring.sq_tail;
+    unsigned queued = 0;
+    unsigned order[count];         // Request of each queue entry, in the order the kernel takes them
+    for (unsigned i = 0; i < count; i++) {
+        MemIoRequest* request = &requests[i];
+        done[i] = false;
+        if (request->length > UINT32_MAX) {
+            continue;
+        }
+        struct io_uring_sqe* sqe = &ring.sqes[tail & mask];
+        memset(sqe, 0, sizeof(*sqe));
+        int buffer_index = fixed_buffer_of(request);
+        if (buffer_index >= 0) {
+            sqe->opcode = request->write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+            sqe->buf_index = (uint16_t)buffer_index;
+        } else {
+            sqe->opcode = request->write ? IORING_OP_WRITE : IORING_OP_READ;
+        }
+        sqe->fd = request->fd;
+        sqe->off = (uint64_t)request->offset;
+        sqe->addr = (uint64_t)(uintptr_t)request->buffer;
+        sqe->len = (uint32_t)request->length;
+        sqe->user_data = i;
+        ring.sq_array[tail & mask] = tail & mask;
+        tail++;
+        order[queued++] = i;
+    }
+    __atomic_store_n(ring.sq_tail, tail, __ATOMIC_RELEASE);
+
+    unsigned unsubmitted = queued;
+    unsigned completed = 0;
+    while (completed < queued) {
+        int submitted = (int)syscall(__NR_io_uring_enter, ring.fd, unsubmitted, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        if (submitted < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                continue;
+            }
+            break;
+        }
+        unsubmitted -= (unsigned)submitted;
+        completed += ring_reap(requests, done);
+    }
+    if (completed == queued) {
+        return true;
+    }
+
+    int error = errno;
+    printf("Error: io_uring_enter failed with errno %d in mem_io_submit.\n", error);
+
+    // The entries the kernel took may still be reading or writing; wait for them without submitting more
+    unsigned in_flight = queued - unsubmitted;
+    while (completed < in_flight) {
+        if (syscall(__NR_io_uring_enter, ring.fd, 0, in_flight - completed, IORING_ENTER_GETEVENTS, NULL, 0) < 0 &&
+            errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            break;
+        }
+        completed += ring_reap(requests, done);
+    }
+    for (unsigned q = 0; q < in_flight; q++) {
+        if (!done[order[q]]) {
+            // Its outcome is unknown, and running it again could repeat a write
+            requests[order[q]].result = -error;
+            done[order[q]] = true;
+        }
+    }
+    return false;
+}
+
+#endif // MEM_IO_URING
+
+/**
+ * @brief Performs one request with pread or pwrite.
+ */
+static void fallback_request(MemIoRequest* request) {
+    ssize_t result = request->write
+        ? pwrite(request->fd, request->buffer, request->length, request->offset)
+        : pread(request->fd, request->buffer, request->length, request->offset);
+    request->result = result < 0 ? -errno : result;
+}
+
+/**
+ * @brief Sets up io_uring and registers the current memory pool as fixed buffers.
+ *
+ * Call after mem_init. When io_uring is unavailable the call still succeeds and
+ * I/O goes through pread/pwrite; mem_io_uring_active tells which path is used.
+ *
+ * @param queue_depth Requests submitted to the kernel at once.
+ * @return true on success, false if already initialized or queue_depth is 0.
+ */
+bool mem_io_init(unsigned queue_depth) {
+    if (queue_depth == 0) {
+        printf("Error: Queue depth must be positive in mem_io_init.\n");
+        return false;
+    }
+    pthread_mutex_lock(&io_lock);
+#ifdef MEM_IO_URING
+    if (ring.fd != -1) {
+        pthread_mutex_unlock(&io_lock);
+        printf("Error: I/O is already initialized in mem_io_init.\n");
+        return false;
+    }
+    if (ring_open(queue_depth)) {
+        atomic_store(&pool_remapped, false);
+        ring_register_pool();
+    }
+#endif
+    pthread_mutex_unlock(&io_lock);
+    return true;
+}
+
+/**
+ * @brief Tears down the ring and its buffer registration. Call before mem_deinit.
+ */
+void mem_io_deinit() {
+    pthread_mutex_lock(&io_lock);
+#ifdef MEM_IO_URING
+    ring_close();
+#endif
+    pthread_mutex_unlock(&io_lock);
+}
+
+/**
+ * @brief Whether requests go through io_uring rather than pread/pwrite.
+ */
+bool mem_io_uring_active() {
+#ifdef MEM_IO_URING
+    return ring.fd != -1;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Performs a batch of reads and writes and waits for all of them.
+ *
+ * Requests run concurrently and may complete in any order, so they must not
+ * overlap. Like pread/pwrite a request can transfer fewer bytes than asked.
+ *
+ * @param requests Requests to perform; each one's result is filled in.
+ * @param count Number of requests.
+ * @return Number of requests that did not fail.
+ */
+size_t mem_io_submit(MemIoRequest* requests, size_t count) {
+    pthread_mutex_lock(&io_lock);
+    size_t next = 0;
+#ifdef MEM_IO_URING
+    if (ring.fd != -1 && atomic_exchange(&pool_remapped, false)) {
+        ring_renew_registration();
+    }
+    while (ring.fd != -1 && next < count) {
+        unsigned batch = count - next < ring.entries ? (unsigned)(count - next) : ring.entries;
+        bool done[batch];
+        bool ok = ring_submit_batch(requests + next, batch, done);
+        if (!ok) {
+            ring_close(); // A ring that failed once is not trusted again; entries it never took go with it
+        }
+        for (unsigned i = 0; i < batch; i++) {
+            if (!done[i]) {
+                fallback_request(&requests[next + i]);
+            }
+        }
+        next += batch;
+    }
+#endif
+    for (; next < count; next++) {
+        fallback_request(&requests[next]);
+    }
+    pthread_mutex_unlock(&io_lock);
+
+    size_t succeeded = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (requests[i].result >= 0) {
+            succeeded++;
+        }
+    }
+    return succeeded;
+}
+
+/**
+ * @brief Notes that pool pages were remapped, e.g. by a resize that moved a block.
+ *
+ * The registered buffers still pin the pages mapped before, so the next
+ * mem_io_submit registers the pool again.
+ */
+void mem_io_pool_remapped() {
+    atomic_store(&pool_remapped, true);
+}
+
+/**
+ * @brief Reads from a file into a block.
+ *
+ * @return Bytes read, or -errno on error.
+ */
+ssize_t mem_io_read(int fd, void* block, size_t length, off_t offset) {
+    MemIoRequest request = {.fd = fd, .buffer = block, .length = length, .offset = offset, .write = false};
+    mem_io_submit(&request, 1);
+    return request.result;
+}
+
+/**
+ * @brief Writes a block to a file.
+ *
+ * @return Bytes written, or -errno on error.
+ */
+ssize_t mem_io_write(int fd, const void* block, size_t length, off_t offset) {
+    MemIoRequest request = {.fd = fd, .buffer = (void*)block, .length = length, .offset = offset, .write = true};
+    mem_io_submit(&request, 1);
+    return request.result;
+}
@@ -0,0 +1,45 @@
+#ifndef MEM_IO_H
+#define MEM_IO_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+// File I/O into memory pool blocks.
+//
+// mem_io_init sets up an io_uring instance and registers the whole pool as
+// fixed buffers, so the kernel pins its pages once instead of on every request.
+// Reads and writes into pool blocks are then submitted as IORING_OP_READ_FIXED
+// and IORING_OP_WRITE_FIXED. Buffers outside the pool (huge blocks, stack or
+// malloc memory) use the unregistered opcodes. Without io_uring (old kernel,
+// seccomp filter, -DMEM_NO_IO_URING) every request falls back to pread/pwrite,
+// so callers need no second code path.
+//
+// The registration covers the pool that was live when mem_io_init ran: call
+// mem_io_deinit before mem_deinit, and mem_io_init again for a new pool.
+// mem_resize can move a large block by remapping its pages, after which the
+// kernel's pinned pages are no longer the ones mapped there; the next
+// mem_io_submit then renews the registration before queueing anything.
+
+// One read or write handed to mem_io_submit
+typedef struct {
+    int fd;
+    void* buffer;               // Usually a mem_alloc'd block
+    size_t length;
+    off_t offset;               // File offset
+    bool write;                 // Write the buffer to the file instead of reading into it
+    ssize_t result;             // Set by mem_io_submit: bytes transferred, or -errno
+} MemIoRequest;
+
+bool mem_io_init(unsigned queue_depth);
+void mem_io_deinit();
+bool mem_io_uring_active();
+size_t mem_io_submit(MemIoRequest* requests, size_t count);
+ssize_t mem_io_read(int fd, void* block, size_t length, off_t offset);
+ssize_t mem_io_write(int fd, const void* block, size_t length, off_t offset);
+
+// Hooks used by the memory manager
+
+void mem_io_pool_remapped();
+
+#endif // MEM_IO_H
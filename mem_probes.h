@@ -0,0 +1,72 @@
+#ifndef MEM_PROBES_H
+#define MEM_PROBES_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Static tracepoints (USDT) in the memory manager and the linked list.
+//
+// When <sys/sdt.h> is available each probe compiles to a single nop plus an ELF
+// note that bpftrace and perf use to attach to a running process; without it,
+// or when built with -DMEM_NO_PROBES, the probes compile to nothing.
+// The *_return probes carry a latency argument. Timing a call costs two clock
+// reads, so it only happens while a tracer has enabled that probe, which the
+// tracer signals through the probe's semaphore.
+//
+// Listing the probes:  bpftrace -l 'usdt:./libmemory_manager.so:*'
+// Size histograms:     bpftrace mem_probes.bt -p <pid>
+
+#if defined(__has_include) && !defined(MEM_NO_PROBES)
+#if __has_include(<sys/sdt.h>)
+#define MEM_PROBES_ENABLED 1
+#endif
+#endif
+
+#ifdef MEM_PROBES_ENABLED
+
+#define _SDT_HAS_SEMAPHORES 1 // Every probe in a file needs a MEM_PROBE_SEMAPHORE definition
+#include <sys/sdt.h>
+
+// Defines the semaphore a tracer increments while the probe is enabled
+#define MEM_PROBE_SEMAPHORE(provider, name) \
+    __extension__ unsigned short provider##_##name##_semaphore __attribute__((unused)) __attribute__((section(".probes")))
+
+#define MEM_PROBE_ACTIVE(provider, name) __builtin_expect(provider##_##name##_semaphore != 0, 0)
+
+#define MEM_PROBE1(provider, name, a) DTRACE_PROBE1(provider, name, a)
+#define MEM_PROBE2(provider, name, a, b) DTRACE_PROBE2(provider, name, a, b)
+#define MEM_PROBE3(provider, name, a, b, c) DTRACE_PROBE3(provider, name, a, b, c)
+#define MEM_PROBE4(provider, name, a, b, c, d) DTRACE_PROBE4(provider, name, a, b, c, d)
+
+#else
+
+// A harmless declaration, so the definitions still need their semicolon
+#define MEM_PROBE_SEMAPHORE(provider, name) extern int provider##_##name##_probe_disabled
+
+#define MEM_PROBE_ACTIVE(provider, name) 0
+
+// sizeof keeps the arguments "used" without evaluating them
+#define MEM_PROBE1(provider, name, a) do { (void)sizeof(a); } while (0)
+#define MEM_PROBE2(provider, name, a, b) do { (void)sizeof(a); (void)sizeof(b); } while (0)
+#define MEM_PROBE3(provider, name, a, b, c) do { (void)sizeof(a); (void)sizeof(b); (void)sizeof(c); } while (0)
+#define MEM_PROBE4(provider, name, a, b, c, d) do { (void)sizeof(a); (void)sizeof(b); (void)sizeof(c); (void)sizeof(d); } while (0)
+
+#endif
+
+/**
+ * @brief Start time for a latency argument, or 0 while nobody traces the return probe.
+ */
+#define MEM_PROBE_START(provider, name) (MEM_PROBE_ACTIVE(provider, name) ? mem_probe_clock() : 0)
+
+/**
+ * @brief Latency since a MEM_PROBE_START value, 0 if timing was off.
+ */
+#define MEM_PROBE_ELAPSED(start) ((start) != 0 ? mem_probe_clock() - (start) : 0)
+
+static inline uint64_t mem_probe_clock() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#endif // MEM_PROBES_H
@@ -0,0 +1,374 @@
+#include "mem_profile.h"
+#include "memory_manager.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <signal.h>
+#include <execinfo.h>
+
+#define MAX_FRAMES 32         // Deepest stack we keep per sample
+#define SKIP_FRAMES 1         // Drop the hook itself from recorded stacks
+#define MAX_SITES 1024        // Distinct call sites (power of two)
+#define MAX_SAMPLES 4096      // Live sampled blocks tracked at once (power of two)
+
+// One distinct allocation call stack
+typedef struct {
+    uint64_t hash;            // Hash of the frames, 0 marks an empty slot
+    int depth;                // Number of valid frames
+    void* frames[MAX_FRAMES]; // Return addresses, leaf first
+    size_t live_bytes;        // Estimated bytes still allocated from this site
+    size_t live_count;        // Sampled blocks still allocated from this site
+} ProfileSite;
+
+// One sampled block that has not been freed yet
+typedef struct {
+    void* block;              // Start of the block, NULL marks an empty slot
+    uint32_t site;            // Index into the site table
+    size_t weight;            // Bytes this sample stands for
+} ProfileSample;
+
+// Global Variables
+static bool profile_enabled = false;         // Whether new allocations are sampled
+static size_t sample_interval = 0;           // Average bytes between samples
+static long long bytes_until_sample = 0;     // Countdown to the next sample
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+static ProfileSite sites[MAX_SITES];
+static ProfileSample samples[MAX_SAMPLES];
+static size_t live_samples = 0;              // Number of occupied sample slots
+static volatile sig_atomic_t dump_requested = 0;
+static const char* dump_path = NULL;
+
+/**
+ * @brief Small xorshift generator; the sampler only needs cheap, spread-out numbers.
+ */
+static uint64_t next_random() {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+/**
+ * @brief Picks the distance to the next sample, uniform in [1, 2 * interval] so it averages to the interval.
+ */
+static void reset_countdown() {
+    bytes_until_sample = (long long)(next_random() % (2 * sample_interval)) + 1;
+}
+
+static size_t sample_slot(void* block) {
+    uint64_t key = (uint64_t)(uintptr_t)block;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return key & (MAX_SAMPLES - 1);
+}
+
+/**
+ * @brief Finds the slot holding a sampled block, or the empty slot where it would go.
+ */
+static size_t find_sample(void* block) {
+    size_t slot = sample_slot(block);
+    while (samples[slot].block != NULL && samples[slot].block != block) {
+        slot = (slot + 1) & (MAX_SAMPLES - 1);
+    }
+    return slot;
+}
+
+/**
+ * @brief Removes a sample slot, shifting later entries back so lookups never hit a gap.
+ */
+static void remove_sample(size_t slot) {
+    size_t next = (slot + 1) & (MAX_SAMPLES - 1);
+    while (samples[next].block != NULL) {
+        size_t home = sample_slot(samples[next].block);
+        // Move the entry back if its home position is not between the hole and its current slot
+        if (((next - home) & (MAX_SAMPLES - 1)) >= ((next - slot) & (MAX_SAMPLES - 1))) {
+            samples[slot] = samples[next];
+            slot = next;
+        }
+        next = (next + 1) & (MAX_SAMPLES - 1);
+    }
+    samples[slot].block = NULL;
+    live_samples--;
+}
+
+/**
+ * @brief Returns the site index for a stack, adding it if it is new, or -1 if the table is full.
+ */
+static int intern_site(void** frames, int depth) {
+    uint64_t hash = 1469598103934665603ULL; // FNV-1a over the return addresses
+    for (int i = 0; i < depth; i++) {
+        hash ^= (uint64_t)(uintptr_t)frames[i];
+        hash *= 1099511628211ULL;
+    }
+    if (hash == 0) {
+        hash = 1; // 0 is reserved for empty slots
+    }
+
+    size_t slot = hash & (MAX_SITES - 1);
+    for (size_t probes = 0; probes < MAX_SITES; probes++) {
+        ProfileSite* site = &sites[slot];
+        if (site->hash == 0) {
+            site->hash = hash;
+            site->depth = depth;
+            memcpy(site->frames, frames, depth * sizeof(void*));
+            return (int)slot;
+        }
+        if (site->hash == hash && site->depth == depth &&
+            memcmp(site->frames, frames, depth * sizeof(void*)) == 0) {
+            return (int)slot;
+        }
+        slot = (slot + 1) & (MAX_SITES - 1);
+    }
+    return -1;
+}
+
+static int dump_locked(FILE* out);
+
+/**
+ * @brief Writes the profile to dump_path if a signal asked for it. The caller holds the pool lock.
+ */
+static void service_dump_request() {
+    if (!dump_requested) {
+        return;
+    }
+    dump_requested = 0;
+
+    FILE* out = fopen(dump_path, "w");
+    if (out == NULL) {
+        perror("fopen");
+        return;
+    }
+    dump_locked(out);
+    fclose(out);
+}
+
+static void dump_signal_handler(int signum) {
+    (void)signum;
+    dump_requested = 1; // Dumping is not async-signal-safe; defer to the next pool operation
+}
+
+/**
+ * @brief Starts sampling allocations.
+ *
+ * @param interval Average number of allocated bytes between samples. 0 selects the default.
+ */
+void mem_profile_start(size_t interval) {
+    mem_lock(); // The recording hooks run under the pool lock
+    sample_interval = interval ? interval : MEM_PROFILE_DEFAULT_INTERVAL;
+    reset_countdown();
+    profile_enabled = true;
+    mem_unlock();
+}
+
+/**
+ * @brief Stops sampling and drops all collected samples.
+ */
+void mem_profile_stop() {
+    mem_lock();
+    profile_enabled = false;
+    memset(sites, 0, sizeof(sites));
+    memset(samples, 0, sizeof(samples));
+    live_samples = 0;
+    mem_unlock();
+}
+
+/**
+ * @brief Writes the live sampled bytes per call site as folded stacks.
+ *
+ * @param out Stream to write the profile to.
+ * @return Number of call sites written, or -1 on error.
+ */
+int mem_profile_dump(FILE* out) {
+    if (out == NULL) {
+        printf("Error: output stream is NULL in mem_profile_dump.\n");
+        return -1;
+    }
+
+    mem_lock();
+    int written = dump_locked(out);
+    mem_unlock();
+    return written;
+}
+
+/**
+ * @brief Writes the profile. The caller holds the pool lock.
+ */
+static int dump_locked(FILE* out) {
+    int written = 0;
+    for (size_t i = 0; i < MAX_SITES; i++) {
+        ProfileSite* site = &sites[i];
+        if (site->hash == 0 || site->live_bytes == 0) {
+            continue;
+        }
+
+        char** symbols = backtrace_symbols(site->frames, site->depth);
+
+        // Folded stacks are root first, so walk the frames from the outermost caller down
+        for (int f = site->depth - 1; f >= 0; f--) {
+            const char* name = symbols ? symbols[f] : NULL;
+            const char* open = name ? strchr(name, '(') : NULL;
+            size_t len = 0;
+            if (open != NULL) {
+                open++;
+                len = strcspn(open, "+)");
+            }
+            if (len > 0) {
+                fprintf(out, "%.*s", (int)len, open);
+            } else {
+                fprintf(out, "%p", site->frames[f]);
+            }
+            fputc(f > 0 ? ';' : ' ', out);
+        }
+        fprintf(out, "%zu\n", site->live_bytes);
+
+        free(symbols);
+        written++;
+    }
+    return written;
+}
+
+/**
+ * @brief Dumps the profile to a file whenever the given signal is received.
+ *
+ * @param signum Signal to listen for (e.g. SIGUSR2).
+ * @param path File the profile is written to (overwritten on each dump).
+ * @return 0 on success, -1 on error.
+ */
+int mem_profile_dump_on_signal(int signum, const char* path) {
+    if (path == NULL) {
+        printf("Error: path is NULL in mem_profile_dump_on_signal.\n");
+        return -1;
+    }
+
+    dump_path = path;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = dump_signal_handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    if (sigaction(signum, &action, NULL) == -1) {
+        perror("sigaction");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Called for every successful allocation; samples roughly one per interval bytes.
+ */
+void mem_profile_record_alloc(void* block, size_t size) {
+    service_dump_request();
+    if (!profile_enabled) {
+        return;
+    }
+
+    // A block of at least one interval is always sampled and stands for itself. Smaller ones are
+    // sampled with probability about size / interval and stand for a whole interval, so the
+    // expected bytes per site match the real ones. Large blocks leave the countdown alone.
+    size_t weight = size;
+    if (size < sample_interval) {
+        bytes_until_sample -= (long long)size;
+        if (bytes_until_sample > 0) {
+            return; // Fast path: this allocation is not sampled
+        }
+        reset_countdown();
+        weight = sample_interval;
+    }
+
+    if (live_samples >= MAX_SAMPLES / 2) {
+        return; // Keep the probe sequences short; skip rather than degrade
+    }
+
+    void* frames[MAX_FRAMES + SKIP_FRAMES];
+    int depth = backtrace(frames, MAX_FRAMES + SKIP_FRAMES) - SKIP_FRAMES;
+    if (depth <= 0) {
+        return;
+    }
+
+    int site = intern_site(frames + SKIP_FRAMES, depth);
+    if (site < 0) {
+        return; // Site table is full
+    }
+
+    size_t slot = find_sample(block);
+    if (samples[slot].block == NULL) {
+        live_samples++;
+    } else {
+        ProfileSite* old = &sites[samples[slot].site];
+        old->live_bytes -= samples[slot].weight;
+        old->live_count--;
+    }
+    samples[slot].block = block;
+    samples[slot].site = (uint32_t)site;
+    samples[slot].weight = weight;
+
+    sites[site].live_bytes += weight;
+    sites[site].live_count++;
+}
+
+/**
+ * @brief Called when a block is resized in place or moved; a sample keeps its call site.
+ */
+void mem_profile_record_resize(void* old_block, void* new_block, size_t new_size) {
+    service_dump_request();
+    if (live_samples == 0) {
+        return;
+    }
+
+    size_t slot = find_sample(old_block);
+    if (samples[slot].block == NULL) {
+        return; // Not a sampled block
+    }
+
+    ProfileSample sample = samples[slot];
+    remove_sample(slot);
+
+    ProfileSite* site = &sites[sample.site];
+    size_t weight = new_size > sample_interval ? new_size : sample_interval;
+    site->live_bytes = site->live_bytes - sample.weight + weight;
+    sample.weight = weight;
+    sample.block = new_block;
+
+    slot = find_sample(new_block);
+    samples[slot] = sample;
+    live_samples++;
+}
+
+/**
+ * @brief Called for every freed block; drops the sample if there is one.
+ */
+void mem_profile_record_free(void* block) {
+    service_dump_request();
+    if (live_samples == 0) {
+        return; // Fast path: nothing sampled is alive
+    }
+
+    size_t slot = find_sample(block);
+    if (samples[slot].block == NULL) {
+        return;
+    }
+
+    ProfileSite* site = &sites[samples[slot].site];
+    site->live_bytes -= samples[slot].weight;
+    site->live_count--;
+    remove_sample(slot);
+}
+
+/**
+ * @brief Called when the whole pool goes away; every sampled block is gone with it.
+ */
+void mem_profile_record_reset() {
+    if (live_samples == 0) {
+        return;
+    }
+    for (size_t i = 0; i < MAX_SITES; i++) {
+        sites[i].live_bytes = 0;
+        sites[i].live_count = 0;
+    }
+    memset(samples, 0, sizeof(samples));
+    live_samples = 0;
+}
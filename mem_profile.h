@@ -0,0 +1,53 @@
+#ifndef MEM_PROFILE_H
+#define MEM_PROFILE_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+// Sampling heap profiler for the memory pool.
+//
+// Roughly one allocation per sample interval bytes records its call stack.
+// Live sampled bytes are aggregated per call site and can be dumped as
+// folded stacks ("root;caller;leaf bytes"), ready for flamegraph.pl.
+
+#define MEM_PROFILE_DEFAULT_INTERVAL (512 * 1024) // Bytes between samples on average
+
+/**
+ * @brief Starts sampling allocations.
+ *
+ * @param sample_interval Average number of allocated bytes between samples. 0 selects the default.
+ */
+void mem_profile_start(size_t sample_interval);
+
+/**
+ * @brief Stops sampling and drops all collected samples.
+ */
+void mem_profile_stop();
+
+/**
+ * @brief Writes the live sampled bytes per call site as folded stacks.
+ *
+ * @param out Stream to write the profile to.
+ * @return Number of call sites written, or -1 on error.
+ */
+int mem_profile_dump(FILE* out);
+
+/**
+ * @brief Dumps the profile to a file whenever the given signal is received.
+ *
+ * The dump itself happens on the next pool operation after the signal, never inside the handler.
+ *
+ * @param signum Signal to listen for (e.g. SIGUSR2).
+ * @param path File the profile is written to (overwritten on each dump).
+ * @return 0 on success, -1 on error.
+ */
+int mem_profile_dump_on_signal(int signum, const char* path);
+
+// Hooks used by the memory manager
+
+void mem_profile_record_alloc(void* block, size_t size);
+void mem_profile_record_resize(void* old_block, void* new_block, size_t new_size);
+void mem_profile_record_free(void* block);
+void mem_profile_record_reset();
+
+#endif // MEM_PROFILE_H
@@ -0,0 +1,202 @@
+#include "mem_stats.h"
+#include "memory_manager.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+// Global Variables
+static MemStatsPage* _Atomic page = NULL;    // Published page, NULL while not publishing
+static _Atomic size_t recorders = 0;         // Threads writing to the page right now, see recorder_enter
+static char page_name[64];                   // Name the page was created under
+
+static uint64_t monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Picks the latency bucket of a call.
+ */
+static int bucket_of(uint64_t ns) {
+    int bucket = 0;
+    while (bucket + 1 < MEM_STATS_BUCKETS && ns >= mem_stats_bucket_floor(bucket + 1)) {
+        bucket++;
+    }
+    return bucket;
+}
+
+/**
+ * @brief Gets the page for writing, or NULL. Pair a non-NULL result with recorder_leave.
+ *
+ * Announcing the writer before loading the page lets mem_stats_unpublish wait for
+ * it before unmapping; both sides use sequentially consistent operations for that.
+ */
+static MemStatsPage* recorder_enter() {
+    if (atomic_load_explicit(&page, memory_order_relaxed) == NULL) {
+        return NULL; // Nothing published; skip the shared counter
+    }
+    atomic_fetch_add(&recorders, 1);
+    MemStatsPage* published = atomic_load(&page);
+    if (published == NULL) {
+        atomic_fetch_sub(&recorders, 1);
+    }
+    return published;
+}
+
+static void recorder_leave() {
+    atomic_fetch_sub_explicit(&recorders, 1, memory_order_release);
+}
+
+/**
+ * @brief Copies a full snapshot of the pool usage onto the page, once when publishing starts.
+ */
+static void refresh_usage() {
+    MemStats stats;
+    mem_get_stats(&stats);
+    mem_stats_set_usage(stats.pool_size, stats.allocated_bytes + stats.huge_bytes, stats.free_bytes);
+    mem_stats_set_largest_free(stats.largest_free_block);
+}
+
+/**
+ * @brief Starts publishing statistics in a shared memory page.
+ *
+ * @param name Name of the page (e.g. "/my_stats"); NULL uses MEM_STATS_PREFIX followed by the pid.
+ * @return 0 on success, -1 on error.
+ */
+int mem_stats_publish(const char* name) {
+    if (page != NULL) {
+        printf("Error: Statistics are already published in mem_stats_publish.\n");
+        return -1;
+    }
+
+    if (name != NULL) {
+        snprintf(page_name, sizeof(page_name), "%s", name);
+    } else {
+        snprintf(page_name, sizeof(page_name), "%s%ld", MEM_STATS_PREFIX, (long)getpid());
+    }
+
+    int fd = shm_open(page_name, O_CREAT | O_TRUNC | O_RDWR, 0644);
+    if (fd == -1) {
+        printf("Error: Statistics page %s could not be created in mem_stats_publish.\n", page_name);
+        return -1;
+    }
+    if (ftruncate(fd, sizeof(MemStatsPage)) == -1) {
+        printf("Error: Statistics page %s could not be sized in mem_stats_publish.\n", page_name);
+        close(fd);
+        shm_unlink(page_name);
+        return -1;
+    }
+
+    MemStatsPage* mapped = mmap(NULL, sizeof(MemStatsPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); // The mapping keeps the object alive
+    if (mapped == MAP_FAILED) {
+        printf("Error: Statistics page %s could not be mapped in mem_stats_publish.\n", page_name);
+        shm_unlink(page_name);
+        return -1;
+    }
+
+    // Fresh pages are zeroed; fill in the identity last so readers never see a half-made page
+    mapped->pid = (uint64_t)getpid();
+    atomic_store(&page, mapped);
+    refresh_usage();
+    atomic_thread_fence(memory_order_release);
+    mapped->magic = MEM_STATS_MAGIC;
+    return 0;
+}
+
+/**
+ * @brief Stops publishing and removes the page.
+ *
+ * Waits for threads still counting an operation into the page before unmapping it.
+ */
+void mem_stats_unpublish() {
+    MemStatsPage* old = atomic_exchange(&page, NULL);
+    if (old == NULL) {
+        return;
+    }
+    while (atomic_load(&recorders) != 0) {
+        sched_yield();
+    }
+    munmap(old, sizeof(MemStatsPage));
+    shm_unlink(page_name);
+}
+
+/**
+ * @brief Start time of a pool operation, or 0 when nothing is published so the clock is not read.
+ */
+uint64_t mem_stats_clock() {
+    return atomic_load_explicit(&page, memory_order_relaxed) != NULL ? monotonic_ns() : 0;
+}
+
+/**
+ * @brief Counts a finished pool operation. Must be called without the pool lock held.
+ *
+ * @param op The operation.
+ * @param start_ns Value mem_stats_clock returned when the operation began.
+ * @param failed Whether the operation failed.
+ */
+void mem_stats_record(MemStatsOp op, uint64_t start_ns, bool failed) {
+    if (start_ns == 0) {
+        return;
+    }
+    MemStatsPage* published = recorder_enter();
+    if (published == NULL) {
+        return;
+    }
+
+    uint64_t now = monotonic_ns();
+    atomic_fetch_add_explicit(&published->ops[op], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&published->latency[bucket_of(now - start_ns)], 1, memory_order_relaxed);
+    if (failed) {
+        atomic_fetch_add_explicit(&published->failures, 1, memory_order_relaxed);
+    }
+    recorder_leave();
+}
+
+/**
+ * @brief Tells whether a page is published, so the memory manager can skip preparing usage updates.
+ */
+bool mem_stats_publishing() {
+    return atomic_load_explicit(&page, memory_order_relaxed) != NULL;
+}
+
+/**
+ * @brief Copies the pool's byte counts onto the page. Cheap enough to call after every operation.
+ *
+ * @param pool_size Size of the pool in bytes.
+ * @param allocated_bytes Bytes in live blocks, huge blocks included.
+ * @param free_bytes Free bytes in the pool.
+ */
+void mem_stats_set_usage(uint64_t pool_size, uint64_t allocated_bytes, uint64_t free_bytes) {
+    MemStatsPage* published = recorder_enter();
+    if (published == NULL) {
+        return;
+    }
+    atomic_store_explicit(&published->pool_size, pool_size, memory_order_relaxed);
+    atomic_store_explicit(&published->allocated_bytes, allocated_bytes, memory_order_relaxed);
+    atomic_store_explicit(&published->free_bytes, free_bytes, memory_order_relaxed);
+    atomic_store_explicit(&published->refreshed_ns, monotonic_ns(), memory_order_relaxed);
+    recorder_leave();
+}
+
+/**
+ * @brief Copies the largest free block onto the page.
+ *
+ * The memory manager finds it with a pass over the pool that is spread over many
+ * operations, and reports it whenever a pass completes.
+ *
+ * @param largest_free_block Size of the largest free run in bytes.
+ */
+void mem_stats_set_largest_free(uint64_t largest_free_block) {
+    MemStatsPage* published = recorder_enter();
+    if (published == NULL) {
+        return;
+    }
+    atomic_store_explicit(&published->largest_free_block, largest_free_block, memory_order_relaxed);
+    recorder_leave();
+}
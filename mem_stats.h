@@ -0,0 +1,74 @@
+#ifndef MEM_STATS_H
+#define MEM_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// Live statistics page for the memory pool.
+//
+// While publishing, the memory manager keeps a small POSIX shared memory page
+// up to date with operation counts, latency buckets and pool usage. Other
+// processes (see mmstat) map it read-only and watch the allocator without
+// stopping it. Every field is written with relaxed atomics: readers see each
+// counter whole, but not a consistent snapshot across counters.
+
+#define MEM_STATS_MAGIC 0x3130544154534d4dULL // "MMSTAT01", set once the page is ready
+#define MEM_STATS_PREFIX "/mmstat."            // Default page name is the prefix plus the pid
+#define MEM_STATS_BUCKETS 16                   // Latency buckets, see mem_stats_bucket_floor
+
+// Operations counted on the page
+typedef enum {
+    MEM_STATS_ALLOC,
+    MEM_STATS_FREE,
+    MEM_STATS_RESIZE,
+    MEM_STATS_OP_COUNT
+} MemStatsOp;
+
+// Layout of the shared page
+typedef struct {
+    uint64_t magic;                            // MEM_STATS_MAGIC once the page is initialized
+    uint64_t pid;                              // Publishing process
+    _Atomic uint64_t pool_size;
+    _Atomic uint64_t allocated_bytes;          // Live blocks, huge blocks included
+    _Atomic uint64_t free_bytes;
+    _Atomic uint64_t largest_free_block;       // As of the last complete pass over the map, see mem_stats_set_largest_free
+    _Atomic uint64_t refreshed_ns;             // CLOCK_MONOTONIC time of the last usage update
+    _Atomic uint64_t ops[MEM_STATS_OP_COUNT];  // Calls per operation
+    _Atomic uint64_t failures;                 // Calls that returned NULL for a non-zero request
+    _Atomic uint64_t latency[MEM_STATS_BUCKETS]; // Calls per latency bucket, all operations together
+} MemStatsPage;
+
+/**
+ * @brief Lower bound of a latency bucket in nanoseconds.
+ *
+ * Bucket 0 holds calls under 128 ns; bucket i > 0 holds [64 << i, 128 << i) ns,
+ * and the last bucket everything slower.
+ */
+static inline uint64_t mem_stats_bucket_floor(int bucket) {
+    return bucket == 0 ? 0 : 64ULL << bucket;
+}
+
+/**
+ * @brief Starts publishing statistics in a shared memory page.
+ *
+ * @param name Name of the page (e.g. "/my_stats"); NULL uses MEM_STATS_PREFIX followed by the pid.
+ * @return 0 on success, -1 on error.
+ */
+int mem_stats_publish(const char* name);
+
+/**
+ * @brief Stops publishing and removes the page.
+ */
+void mem_stats_unpublish();
+
+// Hooks used by the memory manager
+
+uint64_t mem_stats_clock();
+void mem_stats_record(MemStatsOp op, uint64_t start_ns, bool failed);
+bool mem_stats_publishing();
+void mem_stats_set_usage(uint64_t pool_size, uint64_t allocated_bytes, uint64_t free_bytes);
+void mem_stats_set_largest_free(uint64_t largest_free_block);
+
+#endif // MEM_STATS_H
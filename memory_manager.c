@@ -1,258 +1,2320 @@
+#define _GNU_SOURCE // For mremap
 #include "memory_manager.h"
+#include "mem_profile.h"
+#include "mem_stats.h"
+#include "mem_io.h"
+#include "mem_probes.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define POOL_MAGIC 0x4d454d504f4f4c31ULL // "MEMPOOL1", set once a segment is fully initialized
+#define REMAP_MIN_SIZE (64 * 1024)           // Blocks this large move by remapping pages instead of copying
+#define REMAP_MAX_MOVES 1024                 // Remapping moves per pool, see relocate_by_remap
+#define NO_FREE_RUN ((size_t)-1)             // find_free_run found nothing
+#define DEFERRED_CHUNK 64                    // Deferred frees done per hold of the pool lock
+#define STATS_SCAN_CHUNK 4096                // Map bytes the stats page's largest-hole pass covers per operation
+
+// The block start index is a bitmap with one bit per pool byte, plus summary levels
+// where each bit says whether a word of the level below has any bit set.
+// Finding the nearest block start before or after an offset visits one word per level.
+#define INDEX_MAX_LEVELS 8                   // 64^8 bits covers any pool
+#define NO_BLOCK ((size_t)-1)                // The index has no start in the asked direction
+
+// Header in front of a reference-counted block; the caller's pointer follows it
+typedef struct {
+    _Atomic size_t refs;            // Number of owners; the block is freed when it drops to zero
+} RcHeader;
+
+// States of a byte in the allocation map
+#define BYTE_FREE 0
+#define BYTE_ALLOCATED 1
+#define BYTE_RESERVED 2                      // Growth slack owned by the block right before it
+
+// Bookkeeping stored at the start of the pool segment.
+// Everything in here is position independent, so a shared segment works at any mapping address.
+typedef struct {
+    uint64_t magic;                 // POOL_MAGIC once the segment is ready to use
+    size_t segment_size;            // Size of the whole mapping
+    size_t pool_size;               // Total size of the memory pool
+    size_t pool_offset;             // Offset of the pool from the segment start
+    size_t map_offset;              // Offset of the allocation map
+    size_t size_map_offset;         // Offset of the allocation size map
+    size_t size_width;              // Bytes per size map entry: 4 for pools below 4 GiB, otherwise 8
+    int index_levels;               // Levels of the block start index
+    size_t index_offset[INDEX_MAX_LEVELS]; // Offset of each level's bit words
+    size_t index_words[INDEX_MAX_LEVELS];  // Number of 64-bit words per level
+    size_t total_allocated_memory;  // Keeps track of total allocated memory, slack included
+    size_t reserved_memory;         // Part of the above held as growth slack
+    size_t resizes_in_place;        // mem_resize calls that kept the block where it was
+    size_t resizes_moved;           // mem_resize calls that moved the data
+    bool ring;                      // Ring mode: blocks are carved at ring_head and retired from ring_tail
+    bool ring_wrapped;              // The head started over at offset 0 while older blocks remain at the end
+    size_t ring_head;               // Where the next block goes
+    size_t ring_tail;               // Start of the oldest live block
+    size_t ring_end;                // End of the old blocks while wrapped
+    size_t page_region_start;       // First page of the region serving mem_alloc_pages
+    size_t page_region_end;         // End of that region, the last whole page of the pool
+    size_t first_free;              // No byte below this index is free; first-fit searches start here
+    bool shared;                    // Segment lives in shared memory
+    bool locking;                   // Operations take the lock below
+    pthread_mutex_t lock;           // Process-shared when the segment is shared
+} PoolHeader;
+
+// A huge allocation served by its own mapping instead of the pool
+typedef struct {
+    char *block;                    // Start of the mapping, returned to the caller
+    size_t size;                    // Requested size in bytes
+    size_t mapped_size;             // Size of the mapping, a multiple of the page size
+} HugeBlock;
+
+// Phases of a reachability collection cycle
+typedef enum {
+    GC_IDLE,                        // No cycle running
+    GC_MARK,                        // Scanning reached blocks for pointers to more blocks
+    GC_SWEEP                        // Freeing the blocks the mark phase never reached
+} GcPhase;
+
+// State of the incremental collector, kept between mem_gc_step calls
+typedef struct {
+    GcPhase phase;
+    uint64_t *marks;                // One bit per pool byte, set at the start of each reached block
+    char **gray;                    // Reached blocks whose words are not scanned yet
+    size_t gray_count;
+    size_t gray_capacity;
+    char *scan_block;               // Block being scanned, NULL between blocks
+    size_t scan_offset;             // Offset of its next word to look at
+    size_t sweep_index;             // Pool offset the sweep continues from
+    size_t reclaimed_bytes;         // Freed by the sweep of the current or last cycle
+    size_t reclaimed_blocks;
+    bool overflow;                  // The gray stack could not grow; the sweep must not free anything
+} GcState;
+
+// Probe semaphores, see mem_probes.h
+MEM_PROBE_SEMAPHORE(memory_manager, init_entry);
+MEM_PROBE_SEMAPHORE(memory_manager, init_return);
+MEM_PROBE_SEMAPHORE(memory_manager, alloc_entry);
+MEM_PROBE_SEMAPHORE(memory_manager, alloc_return);
+MEM_PROBE_SEMAPHORE(memory_manager, free_entry);
+MEM_PROBE_SEMAPHORE(memory_manager, free_return);
+MEM_PROBE_SEMAPHORE(memory_manager, resize_entry);
+MEM_PROBE_SEMAPHORE(memory_manager, resize_return);
+
+// Frees handed to the background thread in thread-safe mode
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;           // Protects the fields below; may be taken while holding the pool lock, never the reverse
+    pthread_cond_t wake;            // Blocks arrived or the thread must stop
+    pthread_cond_t drained;         // The queue is empty and nothing is being freed
+    void **blocks;                  // Queued blocks
+    size_t count;
+    size_t capacity;
+    size_t in_flight;               // Taken off the queue but not freed yet
+    bool stopping;
+} DeferredFrees;
 
 // Global Variables
+static char *segment = NULL;                // Start of the mapping holding header, pool and maps
+static PoolHeader *pool = NULL;             // Header at the start of the segment
 static char *memory_pool = NULL;            // Pointer to the start of the memory pool
-static bool *allocation_map = NULL;         // Tracks which bytes are allocated
-static size_t *allocation_size_map = NULL;  // Records the size of each allocation
-static size_t total_allocated_memory = 0;   // Keeps track of total allocated memory
+static uint8_t *allocation_map = NULL;      // Tracks which bytes are allocated (BYTE_* states)
+static void *allocation_size_map = NULL;    // Records the size of each allocation, see block_size
+static uint64_t *start_index[INDEX_MAX_LEVELS]; // Ordered index of block starts, level 0 first
 static size_t pool_size = 0;                // Total size of the memory pool
+static size_t mmap_threshold = 0;           // Smallest request served by mmap, 0 (the default) disables
+static bool growth_policy = false;          // Reserve geometric slack for blocks grown by mem_resize
+static HugeBlock *huge_blocks = NULL;       // Live huge allocations of this process, by address
+static size_t huge_count = 0;
+static size_t huge_capacity = 0;
+static size_t huge_total = 0;               // Bytes in live huge blocks, for the stats page
+static GcState gc = {0};                    // Reachability collector, see mem_gc_begin
+static DeferredFrees deferred = {.lock = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER, .drained = PTHREAD_COND_INITIALIZER};
+static _Atomic bool deferred_running = false; // mem_free queues blocks for the background thread
+static bool zero_freed = false;             // Freed pool bytes are cleared before they become free
+static size_t remap_moves = 0;              // Blocks moved by remapping since mem_init
+static size_t stats_scan_index = 0;         // Where the stats page's pass for the largest hole resumes
+static size_t stats_scan_run = 0;           // Free bytes directly before stats_scan_index
+static size_t stats_scan_largest = 0;       // Largest hole seen so far in the current pass
+
+static bool reclaim_deferred_locked();
+
+static size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static size_t page_size() {
+    return (size_t)sysconf(_SC_PAGESIZE);
+}
+
+/**
+ * @brief Queues a reached block for the collector to scan.
+ */
+static void gc_push(char *block) {
+    if (gc.gray_count == gc.gray_capacity) {
+        size_t capacity = gc.gray_capacity ? gc.gray_capacity * 2 : 64;
+        char **grown = realloc(gc.gray, capacity * sizeof(char*));
+        if (grown == NULL) {
+            printf("Collector gray stack could not grow; this cycle will not free anything.\n");
+            gc.overflow = true;
+            return;
+        }
+        gc.gray = grown;
+        gc.gray_capacity = capacity;
+    }
+    gc.gray[gc.gray_count++] = block;
+}
+
+/**
+ * @brief Whether a request should bypass the pool and get a mapping of its own.
+ *
+ * Shared pools keep everything inside the segment, since private mappings are invisible to other processes.
+ */
+static bool use_huge_path(size_t size) {
+    return mmap_threshold != 0 && size >= mmap_threshold && !pool->shared;
+}
+
+/**
+ * @brief Binary search of the registry: index of the first huge block at or above an address.
+ */
+static size_t huge_slot(const void *address) {
+    size_t low = 0;
+    size_t high = huge_count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if ((const char*)huge_blocks[mid].block < (const char*)address) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief Finds the registry entry of a huge block, or NULL if the pointer is not one.
+ */
+static HugeBlock* find_huge(const void *block) {
+    const char *p = block;
+    if (huge_count == 0 || (p >= memory_pool && p < memory_pool + pool_size)) {
+        return NULL; // Pool blocks, the common case, never need the search
+    }
+    size_t slot = huge_slot(block);
+    return slot < huge_count && huge_blocks[slot].block == block ? &huge_blocks[slot] : NULL;
+}
+
+/**
+ * @brief Adds an entry to the registry in address order. The registry has room for it.
+ */
+static HugeBlock* huge_insert(HugeBlock entry) {
+    size_t slot = huge_slot(entry.block);
+    memmove(&huge_blocks[slot + 1], &huge_blocks[slot], (huge_count - slot) * sizeof(HugeBlock));
+    huge_blocks[slot] = entry;
+    huge_count++;
+    return &huge_blocks[slot];
+}
+
+/**
+ * @brief Drops an entry from the registry, keeping the others in address order.
+ */
+static void huge_remove(HugeBlock *huge) {
+    size_t slot = huge - huge_blocks;
+    memmove(huge, huge + 1, (huge_count - slot - 1) * sizeof(HugeBlock));
+    huge_count--;
+}
+
+/**
+ * @brief Serves a huge request with a dedicated anonymous mapping. The caller holds the pool lock.
+ */
+static void* huge_alloc(size_t size) {
+    if (huge_count == huge_capacity) {
+        size_t capacity = huge_capacity ? huge_capacity * 2 : 8;
+        HugeBlock *grown = realloc(huge_blocks, capacity * sizeof(HugeBlock));
+        if (grown == NULL) {
+            printf("Huge block registry could not grow.\n");
+            return NULL;
+        }
+        huge_blocks = grown;
+        huge_capacity = capacity;
+    }
+
+    size_t mapped_size = align_up(size, page_size());
+    char *block = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (block == MAP_FAILED) {
+        printf("Mapping of %zu bytes for a huge block failed.\n", size);
+        return NULL;
+    }
+
+    huge_insert((HugeBlock){.block = block, .size = size, .mapped_size = mapped_size});
+    huge_total += size;
+
+    if (gc.phase == GC_MARK) {
+        gc_push(block); // Huge blocks are roots of a running cycle too
+    }
+    mem_profile_record_alloc(block, size);
+
+    printf("Allocated huge block of %zu bytes outside the pool.\n", size);
+    return block;
+}
+
+/**
+ * @brief Unmaps a huge block and drops it from the registry. The caller holds the pool lock.
+ */
+static void huge_free(HugeBlock *huge) {
+    mem_profile_record_free(huge->block);
+    munmap(huge->block, huge->mapped_size);
+    printf("Huge block freed. Freed %zu bytes.\n", huge->size);
+    huge_total -= huge->size;
+    huge_remove(huge);
+}
+
+/**
+ * @brief Resizes a huge block with mremap, so the kernel moves page table entries instead of copying bytes.
+ */
+static void* huge_resize(HugeBlock *huge, size_t new_size) {
+    size_t mapped_size = align_up(new_size, page_size());
+    if (mapped_size != huge->mapped_size) {
+        char *block = mremap(huge->block, huge->mapped_size, mapped_size, MREMAP_MAYMOVE);
+        if (block == MAP_FAILED) {
+            printf("Remapping huge block to %zu bytes failed.\n", new_size);
+            return NULL;
+        }
+        mem_profile_record_resize(huge->block, block, new_size);
+        if (gc.phase == GC_MARK && block != huge->block) {
+            gc_push(block); // The queued address is stale now
+        }
+        HugeBlock moved = *huge;
+        moved.block = block;
+        moved.mapped_size = mapped_size;
+        huge_remove(huge); // The registry is ordered by address, which may have changed
+        huge = huge_insert(moved);
+    } else {
+        mem_profile_record_resize(huge->block, huge->block, new_size);
+    }
+    huge_total = huge_total - huge->size + new_size;
+    huge->size = new_size;
+
+    printf("Resized huge block to %zu bytes.\n", new_size);
+    return huge->block;
+}
+
+/**
+ * @brief Lays out header, pool and allocation maps in one segment.
+ *
+ * The pool starts on a page boundary; the maps follow it.
+ *
+ * @param header Header to fill in with the offsets.
+ * @param size The size of the memory pool in bytes.
+ */
+static void compute_layout(PoolHeader *header, size_t size) {
+    size_t page = page_size();
+
+    header->pool_size = size;
+    header->pool_offset = align_up(sizeof(PoolHeader), page);
+    header->map_offset = header->pool_offset + align_up(size, page);
+    // Block sizes never exceed the pool size, so smaller pools get away with 32-bit entries
+    header->size_width = size <= UINT32_MAX ? sizeof(uint32_t) : sizeof(size_t);
+    header->size_map_offset = align_up(header->map_offset + size * sizeof(uint8_t), sizeof(size_t));
+    size_t end = align_up(header->size_map_offset + size * header->size_width, sizeof(uint64_t));
+
+    // Block start index: one bit per byte, then one bit per word of the level below
+    size_t bits = size;
+    header->index_levels = 0;
+    do {
+        size_t words = (bits + 63) / 64;
+        header->index_offset[header->index_levels] = end;
+        header->index_words[header->index_levels] = words;
+        header->index_levels++;
+        end += words * sizeof(uint64_t);
+        bits = words;
+    } while (bits > 1);
+
+    header->segment_size = align_up(end, page);
+
+    // The page region starts out empty at the end of the pool and grows downwards
+    header->page_region_end = size / page * page;
+    header->page_region_start = header->page_region_end;
+    header->first_free = 0;
+}
+
+/**
+ * @brief Points the per-process globals at a mapped segment.
+ *
+ * @param base Address the segment is mapped at in this process.
+ */
+static void attach_segment(char *base) {
+    segment = base;
+    pool = (PoolHeader*)base;
+    memory_pool = base + pool->pool_offset;
+    allocation_map = (uint8_t*)(base + pool->map_offset);
+    allocation_size_map = base + pool->size_map_offset;
+    for (int level = 0; level < pool->index_levels; level++) {
+        start_index[level] = (uint64_t*)(base + pool->index_offset[level]);
+    }
+    pool_size = pool->pool_size;
+}
+
+/**
+ * @brief Size of the block starting at an index, 0 if none starts there.
+ */
+static inline size_t block_size(size_t index) {
+    if (pool->size_width == sizeof(uint32_t)) {
+        return ((uint32_t*)allocation_size_map)[index];
+    }
+    return ((size_t*)allocation_size_map)[index];
+}
+
+/**
+ * @brief Records the size of the block starting at an index.
+ */
+static inline void set_block_size(size_t index, size_t size) {
+    if (pool->size_width == sizeof(uint32_t)) {
+        ((uint32_t*)allocation_size_map)[index] = (uint32_t)size;
+    } else {
+        ((size_t*)allocation_size_map)[index] = size;
+    }
+}
+
+/**
+ * @brief Records a block start in the index.
+ */
+static void index_add(size_t index) {
+    for (int level = 0; level < pool->index_levels; level++) {
+        uint64_t *word = &start_index[level][index / 64];
+        bool was_empty = *word == 0;
+        *word |= 1ULL << (index % 64);
+        if (!was_empty) {
+            break; // The levels above already know this word is in use
+        }
+        index = index / 64;
+    }
+}
+
+/**
+ * @brief Removes a block start from the index; removing an index that is not a start is harmless.
+ */
+static void index_remove(size_t index) {
+    for (int level = 0; level < pool->index_levels; level++) {
+        uint64_t *word = &start_index[level][index / 64];
+        *word &= ~(1ULL << (index % 64));
+        if (*word != 0) {
+            break; // Other starts remain in this word
+        }
+        index = index / 64;
+    }
+}
+
+/**
+ * @brief Finds the last set bit at or before index on a level, or NO_BLOCK.
+ */
+static size_t index_pred(int level, size_t index) {
+    size_t w = index / 64;
+    uint64_t word = start_index[level][w] & ((2ULL << (index % 64)) - 1); // Bits up to and including index
+    if (word != 0) {
+        return w * 64 + 63 - __builtin_clzll(word);
+    }
+    if (w == 0 || level + 1 == pool->index_levels) {
+        return NO_BLOCK;
+    }
+
+    size_t prev_word = index_pred(level + 1, w - 1);
+    if (prev_word == NO_BLOCK) {
+        return NO_BLOCK;
+    }
+    return prev_word * 64 + 63 - __builtin_clzll(start_index[level][prev_word]);
+}
+
+/**
+ * @brief Finds the first set bit at or after index on a level, or NO_BLOCK.
+ */
+static size_t index_succ(int level, size_t index) {
+    size_t w = index / 64;
+    if (w >= pool->index_words[level]) {
+        return NO_BLOCK;
+    }
+    uint64_t word = start_index[level][w] & (~0ULL << (index % 64)); // Bits from index on
+    if (word != 0) {
+        return w * 64 + __builtin_ctzll(word);
+    }
+    if (level + 1 == pool->index_levels) {
+        return NO_BLOCK;
+    }
+
+    size_t next_word = index_succ(level + 1, w + 1);
+    if (next_word == NO_BLOCK) {
+        return NO_BLOCK;
+    }
+    return next_word * 64 + __builtin_ctzll(start_index[level][next_word]);
+}
+
+/**
+ * @brief Whether a pool offset is the start of a live block.
+ */
+static bool is_block_start(size_t index) {
+    return (start_index[0][index / 64] >> (index % 64)) & 1;
+}
+
+/**
+ * @brief Marks and queues the pool block a word points into, unless it was reached before.
+ *
+ * Any value inside a live block counts, interior pointers included; free space and slack do not.
+ */
+static void gc_shade(uintptr_t value) {
+    if (value < (uintptr_t)memory_pool || value >= (uintptr_t)memory_pool + pool_size) {
+        return; // Huge blocks are scanned as roots, so only pool blocks need marking
+    }
+    size_t offset = value - (uintptr_t)memory_pool;
+    size_t start = index_pred(0, offset);
+    if (start == NO_BLOCK || offset >= start + block_size(start)) {
+        return;
+    }
+
+    uint64_t bit = 1ULL << (start % 64);
+    if (gc.marks[start / 64] & bit) {
+        return;
+    }
+    gc.marks[start / 64] |= bit;
+    gc_push(memory_pool + start);
+}
+
+/**
+ * @brief Size of a queued block if it is still live, 0 if it was freed or moved since it was queued.
+ */
+static size_t gc_live_size(char *block) {
+    HugeBlock *huge = find_huge(block);
+    if (huge != NULL) {
+        return huge->size;
+    }
+    if (block < memory_pool || block >= memory_pool + pool_size || !is_block_start(block - memory_pool)) {
+        return 0;
+    }
+    return block_size(block - memory_pool);
+}
+
+/**
+ * @brief Treats the word at an offset of a block as a possible pointer.
+ */
+static void gc_scan_word(char *block, size_t offset) {
+    uintptr_t value;
+    memcpy(&value, block + offset, sizeof(value)); // Blocks need not start word aligned
+    gc_shade(value);
+}
+
+/**
+ * @brief Keeps a block created during a cycle: the sweep spares it and the mark phase scans it.
+ */
+static void gc_note_new_block(size_t index) {
+    if (gc.phase == GC_IDLE) {
+        return;
+    }
+    gc.marks[index / 64] |= 1ULL << (index % 64);
+    if (gc.phase == GC_MARK) {
+        gc_push(memory_pool + index);
+    }
+}
+
+/**
+ * @brief Scans a block that is about to be freed while marking.
+ *
+ * Unlinking a node copies its next pointer into a block that may be scanned already;
+ * shading the targets here keeps them from being missed.
+ */
+static void gc_scan_before_free(char *block) {
+    if (gc.phase != GC_MARK) {
+        return;
+    }
+    size_t size = gc_live_size(block);
+    for (size_t offset = 0; offset + sizeof(uintptr_t) <= size; offset += sizeof(uintptr_t)) {
+        gc_scan_word(block, offset);
+    }
+}
+
+/**
+ * @brief Drops the collector's working memory and returns it to idle.
+ */
+static void gc_reset() {
+    free(gc.marks);
+    free(gc.gray);
+    gc.marks = NULL;
+    gc.gray = NULL;
+    gc.gray_count = 0;
+    gc.gray_capacity = 0;
+    gc.scan_block = NULL;
+    gc.phase = GC_IDLE;
+}
+
+/**
+ * @brief Takes the pool lock if the pool is shared between processes.
+ */
+static void pool_lock() {
+    if (pool == NULL || !pool->locking) {
+        return;
+    }
+    if (pthread_mutex_lock(&pool->lock) == EOWNERDEAD) {
+        // A process died while holding the lock; the maps are updated byte by byte, so carry on
+        pthread_mutex_consistent(&pool->lock);
+    }
+}
+
+static void pool_unlock() {
+    if (pool != NULL && pool->locking) {
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/**
+ * @brief Initialize the memory pool with a given size.
+ *
+ * Maps one private segment holding the pool and its allocation maps.
+ * Fresh anonymous memory is zeroed, so all memory starts out free.
+ *
+ * @param size The size of the memory pool in bytes.
+ */
+void mem_init(size_t size) {
+    uint64_t probe_start = MEM_PROBE_START(memory_manager, init_return);
+    MEM_PROBE1(memory_manager, init_entry, size);
+
+    if (size == 0) {
+        printf("Size must be greater than zero.\n");
+        exit(1); // Can't proceed with a pool size of zero
+    }
+
+    PoolHeader layout = {0};
+    compute_layout(&layout, size);
+
+    // Map the pool and the allocation maps in one go
+    char *base = mmap(NULL, layout.segment_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        printf("Memory pool allocation failed!\n");
+        exit(1); // Critical failure; can't continue
+    }
+
+    memcpy(base, &layout, sizeof(PoolHeader));
+    attach_segment(base);
+
+    pool->total_allocated_memory = 0;  // No memory allocated yet
+    pool->magic = POOL_MAGIC;
+
+    printf("Memory pool of size %zu bytes initialized.\n", size);
+    MEM_PROBE3(memory_manager, init_return, size, memory_pool, MEM_PROBE_ELAPSED(probe_start));
+}
+
+/**
+ * @brief Initialize or attach to a memory pool shared between processes.
+ *
+ * The first process to call this creates the shared memory object and initializes it;
+ * later callers attach to it and use the size it was created with. All allocator
+ * metadata lives in the segment and every operation takes a process-shared lock.
+ *
+ * @param name Name of the POSIX shared memory object (e.g. "/my_pool").
+ * @param size The size of the memory pool in bytes, used when creating the pool.
+ */
+void mem_init_shared(const char* name, size_t size) {
+    uint64_t probe_start = MEM_PROBE_START(memory_manager, init_return);
+    MEM_PROBE1(memory_manager, init_entry, size);
+
+    if (name == NULL) {
+        printf("Shared pool name must not be NULL.\n");
+        exit(1);
+    }
+    if (size == 0) {
+        printf("Size must be greater than zero.\n");
+        exit(1);
+    }
+
+    bool creator = true;
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd == -1 && errno == EEXIST) {
+        creator = false;
+        fd = shm_open(name, O_RDWR, 0600);
+    }
+    if (fd == -1) {
+        perror("shm_open");
+        exit(1);
+    }
+
+    PoolHeader layout = {0};
+    compute_layout(&layout, size);
+
+    if (creator) {
+        if (ftruncate(fd, (off_t)layout.segment_size) == -1) {
+            perror("ftruncate");
+            close(fd);
+            shm_unlink(name);
+            exit(1);
+        }
+    } else {
+        // Wait for the creator to size the object, then map whatever size it chose
+        struct stat st;
+        do {
+            if (fstat(fd, &st) == -1) {
+                perror("fstat");
+                close(fd);
+                exit(1);
+            }
+        } while (st.st_size == 0 && usleep(1000) == 0);
+        layout.segment_size = (size_t)st.st_size;
+    }
+
+    char *base = mmap(NULL, layout.segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); // The mapping keeps the object alive
+    if (base == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+
+    PoolHeader *header = (PoolHeader*)base;
+    if (creator) {
+        memcpy(header, &layout, sizeof(PoolHeader));
+        header->total_allocated_memory = 0;
+        header->shared = true;
+        header->locking = true;
+
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init(&header->lock, &attr);
+        pthread_mutexattr_destroy(&attr);
+
+        __atomic_store_n(&header->magic, POOL_MAGIC, __ATOMIC_RELEASE); // Publish only a complete header
+    } else {
+        while (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != POOL_MAGIC) {
+            usleep(1000);
+        }
+        if (header->pool_size != size) {
+            printf("Shared pool %s already exists with %zu bytes; using that size.\n", name, header->pool_size);
+        }
+    }
+
+    attach_segment(base);
+
+    printf("Shared memory pool %s of size %zu bytes %s.\n", name, pool_size, creator ? "initialized" : "attached");
+    MEM_PROBE3(memory_manager, init_return, pool_size, memory_pool, MEM_PROBE_ELAPSED(probe_start));
+}
+
+/**
+ * @brief Remove a shared pool's name so it is destroyed once every process has detached.
+ *
+ * @param name Name of the POSIX shared memory object.
+ */
+void mem_unlink_shared(const char* name) {
+    if (name == NULL || shm_unlink(name) == -1) {
+        printf("Shared pool %s could not be unlinked.\n", name ? name : "(null)");
+        return;
+    }
+    printf("Shared pool %s unlinked.\n", name);
+}
+
+/**
+ * @brief End of the byte-granular space: the start of the page region, or the pool end while that region is empty.
+ */
+static size_t byte_space_end() {
+    return pool->page_region_start < pool->page_region_end ? pool->page_region_start : pool_size;
+}
+
+/**
+ * @brief Whether a pool index lies in the page region.
+ */
+static bool in_page_region(size_t index) {
+    return index >= pool->page_region_start && index < pool->page_region_end;
+}
+
+/**
+ * @brief Finds the first run of free bytes that fits a request.
+ *
+ * @param size Number of bytes needed.
+ * @param alignment Required address alignment of the run start, a power of two.
+ * @return Index of the run start, or NO_FREE_RUN if nothing fits.
+ */
+static size_t find_free_run(size_t size, size_t alignment) {
+    size_t free_blocks = 0;  // Counts consecutive free blocks
+    size_t start_index = 0;  // Starting index of a potential free block
+
+    size_t end = byte_space_end(); // Page blocks have a region of their own
+
+    // Skip the fully allocated prefix, and remember how far it reaches
+    size_t i = pool->first_free;
+    while (i < end && allocation_map[i]) {
+        i++;
+    }
+    pool->first_free = i;
+
+    for (; i < end; i++) {
+        if (!allocation_map[i]) { // If the block is free
+            if (free_blocks == 0) {
+                if (((uintptr_t)(memory_pool + i) & (alignment - 1)) != 0) {
+                    continue; // A run may only start on an aligned address
+                }
+                start_index = i; // Potential start of free block
+            }
+            free_blocks++;
+
+            if (free_blocks == size) {
+                return start_index;
+            }
+        } else {
+            free_blocks = 0; // Reset if block is not free
+        }
+    }
+    return NO_FREE_RUN;
+}
+
+/**
+ * @brief Marks a run of bytes as one allocated block and records its size.
+ */
+static void mark_allocated(size_t start_index, size_t size) {
+    for (size_t j = start_index; j < start_index + size; j++) {
+        allocation_map[j] = BYTE_ALLOCATED;
+    }
+    set_block_size(start_index, size); // Record the size
+    index_add(start_index);
+    gc_note_new_block(start_index);
+    pool->total_allocated_memory += size;
+}
+
+/**
+ * @brief Marks a run of bytes as free again.
+ */
+static void mark_free(size_t start_index, size_t size) {
+    if (size == 0) {
+        return; // start_index may be the next block's start, which must stay indexed
+    }
+    for (size_t i = start_index; i < start_index + size; i++) {
+        allocation_map[i] = BYTE_FREE;
+        set_block_size(i, 0);
+    }
+    index_remove(start_index);
+    pool->total_allocated_memory -= size;
+    if (start_index < pool->first_free) {
+        pool->first_free = start_index;
+    }
+}
+
+/**
+ * @brief Counts the growth slack reserved directly after a block's last byte.
+ */
+static size_t slack_after(size_t end_index) {
+    size_t slack = 0;
+    while (end_index + slack < pool_size && allocation_map[end_index + slack] == BYTE_RESERVED) {
+        slack++;
+    }
+    return slack;
+}
+
+/**
+ * @brief Turns allocated bytes at the end of a block into slack. They stay unavailable to other blocks.
+ */
+static void reserve_range(size_t start_index, size_t size) {
+    memset(allocation_map + start_index, BYTE_RESERVED, size);
+    pool->reserved_memory += size;
+}
+
+/**
+ * @brief Turns slack back into allocated bytes of the block before it.
+ */
+static void claim_range(size_t start_index, size_t size) {
+    memset(allocation_map + start_index, BYTE_ALLOCATED, size);
+    pool->reserved_memory -= size;
+}
+
+/**
+ * @brief Returns slack to the free space.
+ */
+static void release_slack(size_t start_index, size_t size) {
+    mark_free(start_index, size);
+    pool->reserved_memory -= size;
+}
+
+/**
+ * @brief Moves a block's whole pages to a new place in the pool by remapping them.
+ *
+ * MREMAP_DONTUNMAP keeps the source range mapped throughout, so no other mapping
+ * can land in the pool while the pages move; the source then reads as zero pages.
+ * Bytes past the last whole page are copied.
+ *
+ * @return true if the data was moved, false if the kernel refused and the caller must copy.
+ */
+static bool move_pages(char *dest, char *src, size_t size) {
+#ifdef MREMAP_DONTUNMAP
+    size_t whole = size / page_size() * page_size();
+
+    // Kernels before 5.7 reject the flag; the caller copies instead
+    if (mremap(src, whole, whole, MREMAP_MAYMOVE | MREMAP_FIXED | MREMAP_DONTUNMAP, dest) == MAP_FAILED) {
+        return false;
+    }
+    madvise(src, whole, MADV_DONTNEED); // Nothing is left there; make sure no stale page is either
+    mem_io_pool_remapped(); // Buffers registered for I/O still pin the old pages
+
+    memcpy(dest + whole, src + whole, size - whole);
+    return true;
+#else
+    (void)dest;
+    (void)src;
+    (void)size;
+    return false;
+#endif
+}
+
+/**
+ * @brief Relocates a large, page-aligned block without copying its whole pages.
+ *
+ * Only private pools qualify: remapping part of a shared segment would detach it from the other processes.
+ * Each move can split the pool's mapping into more kernel VMAs, which count against
+ * vm.max_map_count (65530 by default), so after REMAP_MAX_MOVES moves blocks are copied instead.
+ *
+ * @return The new block, or NULL if the block does not qualify or no page-aligned run fits.
+ */
+static void* relocate_by_remap(void* block, size_t current_size, size_t new_size) {
+    if (pool->shared || remap_moves >= REMAP_MAX_MOVES || current_size < REMAP_MIN_SIZE || ((uintptr_t)block & (page_size() - 1)) != 0) {
+        return NULL;
+    }
+
+    size_t dest_index = find_free_run(new_size, page_size());
+    if (dest_index == NO_FREE_RUN) {
+        return NULL;
+    }
+
+    char *new_block = memory_pool + dest_index;
+    if (!move_pages(new_block, block, current_size)) {
+        return NULL;
+    }
+    remap_moves++;
+
+    size_t start_index = (char*)block - memory_pool;
+    mark_free(start_index, current_size);
+    mark_allocated(dest_index, new_size);
+    mem_profile_record_resize(block, new_block, new_size);
+
+    printf("Moved block from index %zu to index %zu by remapping pages. Total allocated: %zu bytes.\n", start_index, dest_index, pool->total_allocated_memory);
+    return new_block;
+}
+
+/**
+ * @brief Finds room for a block at the ring head, wrapping to the pool start when the end is reached.
+ *
+ * @return Index of the new block, or NO_FREE_RUN if the ring is full.
+ */
+static size_t ring_reserve(size_t size, size_t alignment) {
+    size_t index = align_up(pool->ring_head, alignment);
+    size_t limit = pool->ring_wrapped ? pool->ring_tail : pool_size;
+    if (index + size > limit) {
+        if (pool->ring_wrapped || size > pool->ring_tail) {
+            return NO_FREE_RUN; // Must wait for the oldest blocks to be freed
+        }
+        // Leave the rest of the pool unused until the tail has passed it
+        pool->ring_end = pool->ring_head;
+        pool->ring_wrapped = true;
+        index = 0;
+    }
+    pool->ring_head = index + size;
+    return index;
+}
+
+/**
+ * @brief Moves the ring tail past every block freed so far, after a block was freed.
+ *
+ * Blocks freed out of order stay behind the tail until the older ones are gone;
+ * their bytes are only reused once the tail has passed them.
+ */
+static void ring_retire() {
+    if (!pool->ring || is_block_start(pool->ring_tail)) {
+        return; // The oldest block is still live
+    }
+
+    size_t next = index_succ(0, pool->ring_tail);
+    if (pool->ring_wrapped) {
+        if (next != NO_BLOCK && next < pool->ring_end) {
+            pool->ring_tail = next;
+            return;
+        }
+        pool->ring_wrapped = false;
+        next = index_succ(0, 0);
+    }
+
+    if (next != NO_BLOCK && next < pool->ring_head) {
+        pool->ring_tail = next;
+    } else {
+        // Empty; start over at the front so the whole pool is one run again
+        pool->ring_head = 0;
+        pool->ring_tail = 0;
+    }
+}
+
+/**
+ * @brief Hands free pages at the bottom of the page region back to the byte-granular space.
+ *
+ * Page blocks cover whole pages, so a page is free when its first byte is.
+ */
+static void page_region_shrink() {
+    while (pool->page_region_start < pool->page_region_end && allocation_map[pool->page_region_start] == BYTE_FREE) {
+        pool->page_region_start += page_size();
+    }
+}
+
+/**
+ * @brief Finds n free pages for a page block, growing the region downwards if needed. The caller holds the pool lock.
+ *
+ * @return Index of the first page, or NO_FREE_RUN if neither the region nor the free bytes below it have room.
+ */
+static size_t page_region_reserve(size_t n_pages) {
+    size_t page = page_size();
+
+    // First fit among the region's free pages
+    size_t run = 0;
+    for (size_t index = pool->page_region_start; index < pool->page_region_end; index += page) {
+        run = allocation_map[index] == BYTE_FREE ? run + 1 : 0;
+        if (run == n_pages) {
+            return index + page - n_pages * page;
+        }
+    }
+
+    // Otherwise take the pages right below the region, which must be untouched by byte blocks
+    if (n_pages > pool->page_region_start / page) {
+        return NO_FREE_RUN;
+    }
+    size_t new_start = pool->page_region_start - n_pages * page;
+    for (size_t i = new_start; i < pool->page_region_start; i++) {
+        if (allocation_map[i] != BYTE_FREE) {
+            return NO_FREE_RUN;
+        }
+    }
+    pool->page_region_start = new_start;
+    return new_start;
+}
+
+/**
+ * @brief Allocate a block of memory whose start is aligned. The caller holds the pool lock.
+ */
+static void* alloc_aligned_locked(size_t size, size_t alignment) {
+    if (size == 0) {
+        printf("Cannot allocate 0 bytes.\n");
+        return NULL; // No point in allocating zero bytes
+    }
+
+    // Ensure the memory pool is initialized
+    if (memory_pool == NULL || allocation_map == NULL || allocation_size_map == NULL) {
+        printf("Memory pool is not initialized.\n");
+        return NULL;
+    }
+
+    if (use_huge_path(size)) {
+        return huge_alloc(size); // Keep huge blocks from fragmenting the pool
+    }
+
+    // Check if there's enough memory left
+    if (pool->total_allocated_memory + size > pool_size) {
+        if (reclaim_deferred_locked()) {
+            return alloc_aligned_locked(size, alignment); // Queued frees made room
+        }
+        printf("Not enough memory available to allocate %zu bytes. Total allocated: %zu bytes.\n", size, pool->total_allocated_memory);
+        return NULL;
+    }
+
+    // First-fit strategy: find the first block that fits; ring mode just takes the next bytes
+    size_t start_index = pool->ring ? ring_reserve(size, alignment) : find_free_run(size, alignment);
+    if (start_index != NO_FREE_RUN) {
+        mark_allocated(start_index, size);
+        mem_profile_record_alloc(memory_pool + start_index, size);
+
+        printf("Allocated %zu bytes at index %zu. Total allocated: %zu bytes.\n", size, start_index, pool->total_allocated_memory);
+        return memory_pool + start_index; // Return pointer to allocated memory
+    }
+
+    // If we reach here, no suitable block was found
+    if (reclaim_deferred_locked()) {
+        return alloc_aligned_locked(size, alignment);
+    }
+    printf("Not enough contiguous memory available to allocate %zu bytes.\n", size);
+    return NULL;
+}
+
+/**
+ * @brief Allocate a block of memory from the pool. The caller holds the pool lock.
+ */
+static void* alloc_locked(size_t size) {
+    return alloc_aligned_locked(size, 1);
+}
+
+/**
+ * @brief Brings the stats page up to date after an operation. The caller holds the pool lock.
+ *
+ * The byte counts are kept by the pool already. The largest hole needs a pass over
+ * the map, so each call covers STATS_SCAN_CHUNK bytes of it and the page gets the
+ * result whenever a pass completes; no single operation pays for the whole pool.
+ */
+static void publish_usage_locked() {
+    if (pool == NULL || !mem_stats_publishing()) {
+        return;
+    }
+
+    if (stats_scan_index >= pool_size) {
+        stats_scan_index = 0;
+        stats_scan_run = 0;
+        stats_scan_largest = 0;
+    }
+    size_t end = stats_scan_index + STATS_SCAN_CHUNK < pool_size ? stats_scan_index + STATS_SCAN_CHUNK : pool_size;
+    for (size_t i = stats_scan_index; i < end; i++) {
+        stats_scan_run = allocation_map[i] == BYTE_FREE ? stats_scan_run + 1 : 0;
+        if (stats_scan_run > stats_scan_largest) {
+            stats_scan_largest = stats_scan_run;
+        }
+    }
+    stats_scan_index = end;
+    if (stats_scan_index == pool_size) {
+        mem_stats_set_largest_free(stats_scan_largest);
+    }
+
+    mem_stats_set_usage(pool_size, pool->total_allocated_memory - pool->reserved_memory + huge_total, pool_size - pool->total_allocated_memory);
+}
+
+/**
+ * @brief Allocate a block of memory from the pool.
+ *
+ * Uses the first-fit strategy to find a contiguous block of the requested size.
+ *
+ * @param size The size of memory to allocate in bytes.
+ * @return Pointer to the allocated memory, or NULL if allocation fails.
+ */
+void* mem_alloc(size_t size) {
+    uint64_t probe_start = MEM_PROBE_START(memory_manager, alloc_return);
+    MEM_PROBE1(memory_manager, alloc_entry, size);
+    uint64_t start = mem_stats_clock();
+    pool_lock();
+    void* block = alloc_locked(size);
+    publish_usage_locked();
+    pool_unlock();
+    mem_stats_record(MEM_STATS_ALLOC, start, block == NULL && size != 0);
+    MEM_PROBE3(memory_manager, alloc_return, size, block, MEM_PROBE_ELAPSED(probe_start));
+    return block;
+}
+
+/**
+ * @brief Allocate a block of memory whose address is a multiple of an alignment.
+ *
+ * Useful for structures sized to a cache line, so each one sits in exactly one line.
+ * The block is freed with mem_free; resizing it may lose the alignment.
+ *
+ * @param size The size of memory to allocate in bytes.
+ * @param alignment Required alignment in bytes, a power of two.
+ * @return Pointer to the allocated memory, or NULL if allocation fails.
+ */
+void* mem_alloc_aligned(size_t size, size_t alignment) {
+    uint64_t probe_start = MEM_PROBE_START(memory_manager, alloc_return);
+    MEM_PROBE1(memory_manager, alloc_entry, size);
+    void* block = NULL;
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        printf("Error: Alignment %zu is not a power of two in mem_alloc_aligned.\n", alignment);
+    } else {
+        uint64_t start = mem_stats_clock();
+        pool_lock();
+        block = alloc_aligned_locked(size, alignment);
+        publish_usage_locked();
+        pool_unlock();
+        mem_stats_record(MEM_STATS_ALLOC, start, block == NULL && size != 0);
+    }
+    MEM_PROBE3(memory_manager, alloc_return, size, block, MEM_PROBE_ELAPSED(probe_start));
+    return block;
+}
+
+/**
+ * @brief Free a previously allocated block of memory. The caller holds the pool lock.
+ */
+static void free_locked(void* block) {
+    gc_scan_before_free(block);
+
+    HugeBlock *huge = find_huge(block);
+    if (huge != NULL) {
+        huge_free(huge);
+        return;
+    }
+
+    if (block == NULL || (char*)block < memory_pool || (char*)block >= memory_pool + pool_size) {
+        printf("Invalid block pointer. It does not belong to the memory pool.\n");
+        return; // Can't free memory outside the pool
+    }
+
+    size_t start_index = (char*)block - memory_pool; // Calculate the index in the pool
+
+    if (!allocation_map[start_index]) {
+        printf("Block at index %zu is already free.\n", start_index);
+        return; // Block is already free
+    }
+
+    size_t size = block_size(start_index);
+    if (size == 0) {
+        printf("No allocation size recorded for block at index %zu.\n", start_index);
+        return; // Inconsistent state
+    }
+
+    mem_profile_record_free(block);
+    if (zero_freed) {
+        memset(block, 0, size);
+    }
+
+    // Mark the blocks as free, together with any slack reserved for growth
+    release_slack(start_index + size, slack_after(start_index + size));
+    mark_free(start_index, size);
+    ring_retire();
+    page_region_shrink();
+
+    printf("Memory block freed. Freed %zu bytes. Total allocated: %zu bytes.\n", size, pool->total_allocated_memory);
+}
+
+/**
+ * @brief Takes up to DEFERRED_CHUNK queued blocks. The caller holds the pool lock and frees them before dropping it.
+ *
+ * Taking and freeing under one hold of the pool lock means an allocation, which
+ * holds the lock too, always finds every pending block still in the queue.
+ */
+static size_t deferred_take(void **batch) {
+    pthread_mutex_lock(&deferred.lock);
+    size_t count = deferred.count < DEFERRED_CHUNK ? deferred.count : DEFERRED_CHUNK;
+    deferred.count -= count;
+    memcpy(batch, deferred.blocks + deferred.count, count * sizeof(void*));
+    deferred.in_flight += count;
+    pthread_mutex_unlock(&deferred.lock);
+    return count;
+}
+
+/**
+ * @brief Reports blocks from deferred_take as freed.
+ */
+static void deferred_done(size_t count) {
+    pthread_mutex_lock(&deferred.lock);
+    deferred.in_flight -= count;
+    if (deferred.count == 0 && deferred.in_flight == 0) {
+        pthread_cond_broadcast(&deferred.drained);
+    }
+    pthread_mutex_unlock(&deferred.lock);
+}
+
+/**
+ * @brief Frees every queued block. The caller holds the pool lock and deferred.lock.
+ */
+static void deferred_drain_held() {
+    while (deferred.count > 0) {
+        free_locked(deferred.blocks[--deferred.count]);
+    }
+    if (deferred.in_flight == 0) {
+        pthread_cond_broadcast(&deferred.drained);
+    }
+}
+
+/**
+ * @brief Frees the queued blocks right away, for an allocation that would fail otherwise. The caller holds the pool lock.
+ *
+ * @return true if any block was freed.
+ */
+static bool reclaim_deferred_locked() {
+    if (!deferred_running) {
+        return false;
+    }
+    void *batch[DEFERRED_CHUNK];
+    size_t total = 0;
+    size_t count;
+    while ((count = deferred_take(batch)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            free_locked(batch[i]);
+        }
+        deferred_done(count);
+        total += count;
+    }
+    return total > 0;
+}
+
+/**
+ * @brief Background thread: frees queued blocks in batches, off the threads that called mem_free.
+ */
+static void* deferred_worker(void* arg) {
+    (void)arg;
+    void *batch[DEFERRED_CHUNK];
+    pthread_mutex_lock(&deferred.lock);
+    while (!deferred.stopping || deferred.count > 0) {
+        if (deferred.count == 0) {
+            pthread_cond_wait(&deferred.wake, &deferred.lock);
+            continue;
+        }
+        pthread_mutex_unlock(&deferred.lock);
+
+        // One chunk per hold of the pool lock lets requests in between chunks
+        pool_lock();
+        size_t count = deferred_take(batch);
+        for (size_t i = 0; i < count; i++) {
+            free_locked(batch[i]);
+        }
+        publish_usage_locked();
+        pool_unlock();
+        deferred_done(count);
+
+        pthread_mutex_lock(&deferred.lock);
+    }
+    pthread_mutex_unlock(&deferred.lock);
+    return NULL;
+}
+
+/**
+ * @brief Queues a block for the background thread.
+ *
+ * @return false if deferred frees are off or the queue could not grow; the caller frees the block itself.
+ */
+static bool deferred_push(void* block) {
+    pthread_mutex_lock(&deferred.lock);
+    if (!deferred_running) {
+        pthread_mutex_unlock(&deferred.lock); // Switched off since the caller looked; nothing would drain the queue
+        return false;
+    }
+    if (deferred.count == deferred.capacity) {
+        size_t capacity = deferred.capacity ? deferred.capacity * 2 : 256;
+        void **grown = realloc(deferred.blocks, capacity * sizeof(void*));
+        if (grown == NULL) {
+            pthread_mutex_unlock(&deferred.lock);
+            return false;
+        }
+        deferred.blocks = grown;
+        deferred.capacity = capacity;
+    }
+    deferred.blocks[deferred.count++] = block;
+    if (deferred.count == 1) {
+        pthread_cond_signal(&deferred.wake);
+    }
+    pthread_mutex_unlock(&deferred.lock);
+    return true;
+}
+
+/**
+ * @brief Free a previously allocated block of memory.
+ *
+ * Marks the block as free and updates the allocation maps. With deferred
+ * frees on, the block is only queued and the background thread frees it;
+ * mistakes such as double frees are then reported from that thread.
+ *
+ * @param block Pointer to the memory block to free.
+ */
+void mem_free(void* block) {
+    uint64_t probe_start = MEM_PROBE_START(memory_manager, free_return);
+    MEM_PROBE1(memory_manager, free_entry, block);
+    uint64_t start = mem_stats_clock();
+    if (!deferred_running || block == NULL || !deferred_push(block)) {
+        pool_lock();
+        free_locked(block);
+        publish_usage_locked();
+        pool_unlock();
+    }
+    mem_stats_record(MEM_STATS_FREE, start, false);
+    MEM_PROBE2(memory_manager, free_return, block, MEM_PROBE_ELAPSED(probe_start));
+}
+
+/**
+ * @brief Grows a plain allocated block to new_size, wherever that takes it. The caller holds the pool lock.
+ *
+ * Tries, in order: the free bytes after the block, free bytes on both sides (sliding the data back),
+ * moving whole pages, and finally a fresh allocation plus copy.
+ *
+ * @return The grown block, or NULL if there is no room anywhere.
+ */
+static void* grow_locked(void* block, size_t current_size, size_t new_size) {
+    size_t start_index = (char*)block - memory_pool;
+
+    // Check if we can expand the block in place
+    size_t i;
+    for (i = start_index + current_size; i < start_index + new_size; i++) {
+        if (i >= pool_size || allocation_map[i]) {
+            break; // Can't expand further
+        }
+    }
+
+    if (i == start_index + new_size) {
+        // Enough space to expand in place
+        for (size_t j = start_index + current_size; j < start_index + new_size; j++) {
+            allocation_map[j] = BYTE_ALLOCATED;
+        }
+        set_block_size(start_index, new_size);
+        pool->total_allocated_memory += (new_size - current_size);
+        pool->resizes_in_place++;
+        mem_profile_record_resize(block, block, new_size);
+
+        printf("Expanded block at index %zu to %zu bytes. Total allocated: %zu bytes.\n", start_index, new_size, pool->total_allocated_memory);
+        return block; // Successfully resized in place
+    }
+
+    // Not enough room after the block; see if free space just before it makes up the difference
+    size_t free_after = i - (start_index + current_size);
+    size_t needed_before = new_size - current_size - free_after;
+    size_t free_before = 0;
+    while (free_before < needed_before && free_before < start_index && !allocation_map[start_index - free_before - 1]) {
+        free_before++;
+    }
+
+    if (free_before == needed_before) {
+        // Slide the data back into the preceding space; the ranges overlap, hence memmove
+        size_t new_index = start_index - needed_before;
+        char* new_block = memory_pool + new_index;
+        memmove(new_block, block, current_size);
+
+        mark_free(start_index, current_size);
+        mark_allocated(new_index, new_size);
+        pool->resizes_moved++;
+        mem_profile_record_resize(block, new_block, new_size);
+
+        printf("Expanded block at index %zu backwards to index %zu, %zu bytes. Total allocated: %zu bytes.\n", start_index, new_index, new_size, pool->total_allocated_memory);
+        return new_block;
+    }
+
+    // Large page-aligned blocks can move without copying their bytes
+    if (!use_huge_path(new_size)) {
+        void* moved = relocate_by_remap(block, current_size, new_size);
+        if (moved != NULL) {
+            pool->resizes_moved++;
+            return moved;
+        }
+    }
+
+    // If in-place expansion isn't possible, allocate a new block
+    void* new_block = alloc_locked(new_size);
+    if (new_block) {
+        memcpy(new_block, block, current_size); // Copy existing data to the new block (it may be a huge block now)
+        free_locked(block); // Free the old block
+        pool->resizes_moved++;
+
+        printf("Resized block by allocating new block of %zu bytes and freeing old block. Total allocated: %zu bytes.\n", new_size, pool->total_allocated_memory);
+    }
+
+    return new_block; // Return the new block or NULL if allocation failed
+}
+
+/**
+ * @brief Gives a block at least capacity bytes while keeping its size. The caller holds the pool lock.
+ *
+ * The bytes past the size become slack that later growth claims without moving the block.
+ *
+ * @return The block, possibly moved, or NULL if the capacity could not be obtained (the block is unchanged).
+ */
+static void* reserve_locked(void* block, size_t size, size_t capacity) {
+    size_t start_index = (char*)block - memory_pool;
+    size_t slack = slack_after(start_index + size);
+
+    // Absorb the current slack so the block is one plain allocated run while it grows
+    claim_range(start_index + size, slack);
+    set_block_size(start_index, size + slack);
+
+    void* new_block = grow_locked(block, size + slack, capacity);
+    if (new_block == NULL) {
+        reserve_range(start_index + size, slack);
+        set_block_size(start_index, size);
+        return NULL;
+    }
+
+    if (find_huge(new_block) == NULL) {
+        size_t new_index = (char*)new_block - memory_pool;
+        set_block_size(new_index, size);
+        reserve_range(new_index + size, capacity - size);
+    }
+    return new_block;
+}
+
+/**
+ * @brief Grows a block in ring mode. The caller holds the pool lock.
+ *
+ * Only the newest block can grow in place, by pushing the head further; any
+ * other block moves to the head, since the bytes after it belong to newer blocks
+ * or are waiting for the tail.
+ */
+static void* ring_grow_locked(void* block, size_t current_size, size_t new_size) {
+    size_t start_index = (char*)block - memory_pool;
+    size_t limit = pool->ring_wrapped ? pool->ring_tail : pool_size;
+
+    if (start_index + current_size == pool->ring_head && start_index + new_size <= limit) {
+        memset(allocation_map + start_index + current_size, BYTE_ALLOCATED, new_size - current_size);
+        set_block_size(start_index, new_size);
+        pool->total_allocated_memory += new_size - current_size;
+        pool->ring_head = start_index + new_size;
+        pool->resizes_in_place++;
+        mem_profile_record_resize(block, block, new_size);
+
+        printf("Expanded block at index %zu at the ring head to %zu bytes. Total allocated: %zu bytes.\n", start_index, new_size, pool->total_allocated_memory);
+        return block;
+    }
+
+    void* new_block = alloc_locked(new_size);
+    if (new_block != NULL) {
+        memcpy(new_block, block, current_size);
+        free_locked(block);
+        pool->resizes_moved++;
+    }
+    return new_block;
+}
+
+/**
+ * @brief Resize an allocated memory block. The caller holds the pool lock.
+ */
+static void* resize_locked(void* block, size_t new_size) {
+    if (block == NULL) {
+        // If block is NULL, behave like mem_alloc
+        return alloc_locked(new_size);
+    }
+
+    if (new_size == 0) {
+        // If new size is zero, free the block
+        free_locked(block);
+        return NULL;
+    }
+
+    HugeBlock *huge = find_huge(block);
+    if (huge != NULL) {
+        if (use_huge_path(new_size)) {
+            return huge_resize(huge, new_size);
+        }
+
+        // Shrunk below the threshold; move it into the pool if there is room
+        void* new_block = alloc_locked(new_size);
+        if (new_block == NULL) {
+            return huge_resize(huge, new_size);
+        }
+        memcpy(new_block, block, new_size);
+        huge_free(huge);
+        return new_block;
+    }
+
+    size_t start_index = (char*)block - memory_pool; // Find the block's start index
+    size_t current_size = block_size(start_index);
+
+    if (in_page_region(start_index)) {
+        printf("Page buffer at index %zu cannot be resized.\n", start_index);
+        return NULL;
+    }
+
+    if (current_size == 0) {
+        printf("No allocation size recorded for block at index %zu.\n", start_index);
+        return NULL; // Can't resize an untracked block
+    }
+
+    if (pool->ring && new_size > current_size) {
+        return ring_grow_locked(block, current_size, new_size);
+    }
+
+    size_t slack = slack_after(start_index + current_size);
+    size_t capacity = current_size + slack;
+
+    if (new_size <= current_size) {
+        if (growth_policy && new_size >= capacity / 4) {
+            // Keep the bytes as slack; a growing buffer is likely to need them again
+            reserve_range(start_index + new_size, current_size - new_size);
+        } else {
+            // Shrinking the block; free the extra space and any slack
+            mark_free(start_index + new_size, current_size - new_size);
+            release_slack(start_index + current_size, slack);
+        }
+        set_block_size(start_index, new_size);
+        pool->resizes_in_place++;
+        mem_profile_record_resize(block, block, new_size);
+
+        printf("Resized block at index %zu to %zu bytes. Total allocated: %zu bytes.\n", start_index, new_size, pool->total_allocated_memory);
+        return block; // Return the same block since it's resized in place
+    }
+
+    if (new_size <= capacity) {
+        // The slack reserved after the block covers the growth
+        claim_range(start_index + current_size, new_size - current_size);
+        set_block_size(start_index, new_size);
+        pool->resizes_in_place++;
+        mem_profile_record_resize(block, block, new_size);
+
+        printf("Expanded block at index %zu into its slack, %zu bytes. Total allocated: %zu bytes.\n", start_index, new_size, pool->total_allocated_memory);
+        return block;
+    }
+
+    // Growing geometrically makes a series of small increments cost amortised O(1) each
+    size_t target = new_size;
+    if (growth_policy && capacity * 2 > new_size && !use_huge_path(capacity * 2)) {
+        target = capacity * 2;
+    }
+
+    void* new_block = reserve_locked(block, current_size, target);
+    if (new_block == NULL && target != new_size) {
+        new_block = reserve_locked(block, current_size, new_size);
+    }
+    if (new_block == NULL) {
+        return NULL;
+    }
+
+    // The grown block is still current_size long with slack after it; claim what was asked for
+    if (find_huge(new_block) == NULL) {
+        size_t new_index = (char*)new_block - memory_pool;
+        claim_range(new_index + current_size, new_size - current_size);
+        set_block_size(new_index, new_size);
+        mem_profile_record_resize(new_block, new_block, new_size);
+    }
+    return new_block;
+}
 
 /**
- * @brief Initialize the memory pool with a given size.
+ * @brief Resize an allocated memory block.
  *
- * Allocates memory for the pool and initializes allocation maps.
+ * Attempts to resize the block in place; if not possible, allocates a new block,
+ * copies the data, and frees the old block.
  *
- * @param size The size of the memory pool in bytes.
+ * @param block Pointer to the memory block to resize.
+ * @param new_size The new size in bytes.
+ * @return Pointer to the resized memory block, or NULL if resizing fails.
  */
-void mem_init(size_t size) {
-    if (size == 0) {
-        printf("Size must be greater than zero.\n");
-        exit(1); // Can't proceed with a pool size of zero
+void* mem_resize(void* block, size_t new_size) {
+    uint64_t probe_start = MEM_PROBE_START(memory_manager, resize_return);
+    MEM_PROBE2(memory_manager, resize_entry, block, new_size);
+    uint64_t start = mem_stats_clock();
+    pool_lock();
+    void* new_block = resize_locked(block, new_size);
+    publish_usage_locked();
+    pool_unlock();
+    mem_stats_record(MEM_STATS_RESIZE, start, new_block == NULL && new_size != 0);
+    MEM_PROBE4(memory_manager, resize_return, block, new_size, new_block, MEM_PROBE_ELAPSED(probe_start));
+    return new_block;
+}
+
+/**
+ * @brief Switch the pool between first-fit and ring allocation.
+ *
+ * In ring mode mem_alloc carves each block right after the previous one and
+ * wraps around at the end of the pool, and the space is handed back as the
+ * oldest blocks are freed. Blocks freed out of order are kept until every
+ * older block is gone. For blocks that die roughly in the order they were
+ * made, allocating and freeing take constant time and never fragment the pool.
+ * The mode can only change while the pool holds no blocks.
+ *
+ * @param enabled true for ring allocation, false for first fit.
+ */
+void mem_set_ring_mode(bool enabled) {
+    pool_lock();
+    if (pool == NULL || pool->total_allocated_memory != 0) {
+        printf("Error: The pool must be initialized and empty in mem_set_ring_mode.\n");
+    } else {
+        pool->ring = enabled;
+        pool->ring_wrapped = false;
+        pool->ring_head = 0;
+        pool->ring_tail = 0;
+        pool->ring_end = 0;
     }
+    pool_unlock();
+}
 
-    // Allocate the memory pool
-    memory_pool = (char*)malloc(size);
-    if (memory_pool == NULL) {
-        printf("Memory pool allocation failed!\n");
-        exit(1); // Critical failure; can't continue
+/**
+ * @brief Make the pool safe to use from several threads of this process.
+ *
+ * Every operation then takes a mutex, as it already does for shared pools.
+ * Call it before other threads start using the pool. Shared pools always lock.
+ *
+ * @param enabled true to lock around every operation, false to stop locking.
+ */
+void mem_set_thread_safe(bool enabled) {
+    if (pool == NULL) {
+        printf("Error: Memory pool is not initialized in mem_set_thread_safe.\n");
+        return;
+    }
+    if (pool->shared || pool->locking == enabled) {
+        return;
     }
 
-    // Allocate the allocation map (one bool per byte)
-    allocation_map = (bool*)malloc(size * sizeof(bool));
-    if (allocation_map == NULL) {
-        printf("Allocation map creation failed!\n");
-        free(memory_pool); // Clean up before exiting
-        exit(1);
+    if (enabled) {
+        pthread_mutex_init(&pool->lock, NULL);
+        pool->locking = true;
+    } else {
+        mem_set_deferred_free(false, false); // The background thread needs the lock
+        pool->locking = false;
+        pthread_mutex_destroy(&pool->lock);
     }
+}
 
-    // Allocate the allocation size map
-    allocation_size_map = (size_t*)malloc(size * sizeof(size_t));
-    if (allocation_size_map == NULL) {
-        printf("Allocation size map creation failed!\n");
-        free(memory_pool);
-        free(allocation_map);
-        exit(1);
+/**
+ * @brief Hand frees to a background thread, optionally clearing freed memory.
+ *
+ * mem_free then only queues the block; the thread returns queued blocks to the
+ * pool in batches, so callers no longer pay for updating the maps and the block
+ * index (or for zeroing) while holding the pool lock. An allocation that would
+ * fail frees the queue first. Needs thread-safe mode or a shared pool.
+ *
+ * @param enabled true to start the background thread, false to stop it after it emptied the queue.
+ * @param zero true to clear every freed block before its bytes become free again.
+ */
+void mem_set_deferred_free(bool enabled, bool zero) {
+    if (enabled && (pool == NULL || !pool->locking)) {
+        printf("Error: Deferred frees need a thread-safe pool in mem_set_deferred_free.\n");
+        return;
     }
 
-    // Initialize allocation maps to indicate all memory is free
-    for (size_t i = 0; i < size; i++) {
-        allocation_map[i] = false;
-        allocation_size_map[i] = 0;
+    pool_lock();
+    zero_freed = enabled && zero;
+    pool_unlock();
+
+    if (enabled && !deferred_running) {
+        deferred.stopping = false;
+        if (pthread_create(&deferred.thread, NULL, deferred_worker, NULL) != 0) {
+            printf("Error: Background thread could not start in mem_set_deferred_free.\n");
+            return;
+        }
+        pthread_mutex_lock(&deferred.lock);
+        deferred_running = true;
+        pthread_mutex_unlock(&deferred.lock);
+    } else if (!enabled && deferred_running) {
+        // Under the queue lock, so no mem_free can push once the worker may have seen it stop
+        pthread_mutex_lock(&deferred.lock);
+        deferred_running = false; // New frees happen in place again
+        deferred.stopping = true;
+        pthread_cond_signal(&deferred.wake);
+        pthread_mutex_unlock(&deferred.lock);
+        pthread_join(deferred.thread, NULL);
+
+        pool_lock();
+        pthread_mutex_lock(&deferred.lock);
+        deferred_drain_held(); // Nothing should be left, but a queued block must not outlive the queue
+        free(deferred.blocks);
+        deferred.blocks = NULL;
+        deferred.capacity = 0;
+        pthread_mutex_unlock(&deferred.lock);
+        pool_unlock();
     }
+}
 
-    pool_size = size;               // Set the total pool size
-    total_allocated_memory = 0;    // No memory allocated yet
+/**
+ * @brief Wait until every queued free has been done.
+ */
+void mem_flush_deferred() {
+    pthread_mutex_lock(&deferred.lock);
+    while (deferred.count > 0 || deferred.in_flight > 0) {
+        pthread_cond_wait(&deferred.drained, &deferred.lock);
+    }
+    pthread_mutex_unlock(&deferred.lock);
+}
 
-    printf("Memory pool of size %zu bytes initialized.\n", size);
+/**
+ * @brief Allocates whole pages from the page region; see mem_alloc_pages.
+ */
+static void* alloc_pages(size_t n_pages) {
+    if (n_pages == 0) {
+        printf("Cannot allocate 0 pages.\n");
+        return NULL;
+    }
+
+    uint64_t start = mem_stats_clock();
+    if (n_pages > SIZE_MAX / page_size()) {
+        printf("Error: %zu pages do not fit in the address space in mem_alloc_pages.\n", n_pages);
+        mem_stats_record(MEM_STATS_ALLOC, start, true);
+        return NULL;
+    }
+
+    pool_lock();
+    if (pool == NULL || pool->ring) {
+        printf("Error: Page buffers need an initialized pool outside ring mode in mem_alloc_pages.\n");
+        pool_unlock();
+        mem_stats_record(MEM_STATS_ALLOC, start, true);
+        return NULL;
+    }
+
+    size_t size = n_pages * page_size();
+    size_t start_index = page_region_reserve(n_pages);
+    if (start_index == NO_FREE_RUN && reclaim_deferred_locked()) {
+        start_index = page_region_reserve(n_pages);
+    }
+    void* block = NULL;
+    if (start_index != NO_FREE_RUN) {
+        mark_allocated(start_index, size);
+        mem_profile_record_alloc(memory_pool + start_index, size);
+        block = memory_pool + start_index;
+        printf("Allocated %zu pages at index %zu. Total allocated: %zu bytes.\n", n_pages, start_index, pool->total_allocated_memory);
+    } else {
+        printf("Not enough free pages available to allocate %zu pages.\n", n_pages);
+    }
+    publish_usage_locked();
+    pool_unlock();
+    mem_stats_record(MEM_STATS_ALLOC, start, block == NULL);
+    return block;
 }
 
 /**
- * @brief Allocate a block of memory from the pool.
+ * @brief Allocate a page-aligned buffer of whole pages, e.g. for O_DIRECT I/O.
  *
- * Uses the first-fit strategy to find a contiguous block of the requested size.
+ * Page buffers come from a region at the end of the pool that grows downwards
+ * a page at a time and shrinks back when its lowest pages are freed, so they
+ * never leave odd-sized holes between byte-granular blocks. Free them with
+ * mem_free; they cannot be resized. Not available in ring mode.
  *
- * @param size The size of memory to allocate in bytes.
- * @return Pointer to the allocated memory, or NULL if allocation fails.
+ * @param n_pages Number of pages.
+ * @return Pointer to the first page, or NULL if allocation fails.
  */
-void* mem_alloc(size_t size) {
+void* mem_alloc_pages(size_t n_pages) {
+    size_t size = n_pages <= SIZE_MAX / page_size() ? n_pages * page_size() : SIZE_MAX; // Saturated for the probes
+    uint64_t probe_start = MEM_PROBE_START(memory_manager, alloc_return);
+    MEM_PROBE1(memory_manager, alloc_entry, size);
+    void* block = alloc_pages(n_pages);
+    MEM_PROBE3(memory_manager, alloc_return, size, block, MEM_PROBE_ELAPSED(probe_start));
+    return block;
+}
+
+/**
+ * @brief Allocate a block whose reference count lives in a header inside the block.
+ *
+ * The block starts with one reference. The count is updated with atomic
+ * operations, so threads may retain and release it without a lock; the last
+ * release frees it. Use mem_release, not mem_free, on such blocks.
+ *
+ * @param size The size of memory to allocate in bytes, not counting the header.
+ * @return Pointer to the caller's part of the block, or NULL if allocation fails.
+ */
+void* mem_alloc_rc(size_t size) {
+    uint64_t probe_start = MEM_PROBE_START(memory_manager, alloc_return);
+    MEM_PROBE1(memory_manager, alloc_entry, size);
+    void* block = NULL;
     if (size == 0) {
         printf("Cannot allocate 0 bytes.\n");
-        return NULL; // No point in allocating zero bytes
+    } else {
+        // The count is only lock free when it is naturally aligned
+        uint64_t start = mem_stats_clock();
+        pool_lock();
+        RcHeader* header = alloc_aligned_locked(sizeof(RcHeader) + size, _Alignof(RcHeader));
+        publish_usage_locked();
+        pool_unlock();
+        mem_stats_record(MEM_STATS_ALLOC, start, header == NULL);
+        if (header != NULL) {
+            atomic_init(&header->refs, 1);
+            block = header + 1;
+        }
     }
+    MEM_PROBE3(memory_manager, alloc_return, size, block, MEM_PROBE_ELAPSED(probe_start));
+    return block;
+}
 
-    // Ensure the memory pool is initialized
-    if (memory_pool == NULL || allocation_map == NULL || allocation_size_map == NULL) {
-        printf("Memory pool is not initialized.\n");
+/**
+ * @brief Add a reference to a block from mem_alloc_rc.
+ *
+ * @param block Pointer returned by mem_alloc_rc.
+ * @return The same pointer, for convenience.
+ */
+void* mem_retain(void* block) {
+    if (block == NULL) {
+        printf("Error: block is NULL in mem_retain.\n");
         return NULL;
     }
 
-    // Check if there's enough memory left
-    if (total_allocated_memory + size > pool_size) {
-        printf("Not enough memory available to allocate %zu bytes. Total allocated: %zu bytes.\n", size, total_allocated_memory);
-        return NULL;
+    // A new reference can only be made from an existing one, so no ordering is needed
+    RcHeader* header = (RcHeader*)block - 1;
+    atomic_fetch_add_explicit(&header->refs, 1, memory_order_relaxed);
+    return block;
+}
+
+/**
+ * @brief Drop a reference to a block from mem_alloc_rc, freeing it with the last one.
+ *
+ * @param block Pointer returned by mem_alloc_rc.
+ * @return References left; 0 means the block was freed.
+ */
+size_t mem_release(void* block) {
+    if (block == NULL) {
+        printf("Error: block is NULL in mem_release.\n");
+        return 0;
     }
 
-    size_t free_blocks = 0;  // Counts consecutive free blocks
-    size_t start_index = 0;  // Starting index of a potential free block
+    RcHeader* header = (RcHeader*)block - 1;
+    size_t left = atomic_fetch_sub_explicit(&header->refs, 1, memory_order_release) - 1;
+    if (left == 0) {
+        // Make every other owner's writes visible before the memory is reused
+        atomic_thread_fence(memory_order_acquire);
+        mem_free(header);
+    }
+    return left;
+}
 
-    // First-fit strategy: find the first block that fits
-    for (size_t i = 0; i < pool_size; i++) {
-        if (!allocation_map[i]) { // If the block is free
-            if (free_blocks == 0) {
-                start_index = i; // Potential start of free block
-            }
-            free_blocks++;
+/**
+ * @brief Read the reference count of a block from mem_alloc_rc.
+ *
+ * @param block Pointer returned by mem_alloc_rc.
+ * @return Current number of references; only a hint while other threads hold some.
+ */
+size_t mem_ref_count(const void* block) {
+    if (block == NULL) {
+        return 0;
+    }
+    const RcHeader* header = (const RcHeader*)block - 1;
+    return atomic_load_explicit(&header->refs, memory_order_relaxed);
+}
 
-            if (free_blocks == size) {
-                // Found a suitable block; mark it as allocated
-                for (size_t j = start_index; j < start_index + size; j++) {
-                    allocation_map[j] = true;
-                }
-                allocation_size_map[start_index] = size; // Record the size
-                total_allocated_memory += size;
+/**
+ * @brief Enable or disable geometric growth for blocks resized with mem_resize.
+ *
+ * With the policy on, a block that has to grow past its neighbours gets twice
+ * its capacity and keeps the extra bytes as slack, so a buffer grown in small
+ * steps only moves O(log n) times. Shrinking keeps the slack unless the block
+ * drops below a quarter of its capacity.
+ *
+ * @param enabled true to reserve slack, false for exact-size resizing.
+ */
+void mem_set_growth_policy(bool enabled) {
+    pool_lock();
+    growth_policy = enabled;
+    pool_unlock();
+}
 
-                printf("Allocated %zu bytes at index %zu. Total allocated: %zu bytes.\n", size, start_index, total_allocated_memory);
-                return memory_pool + start_index; // Return pointer to allocated memory
+/**
+ * @brief Reserve room for a block to grow to an expected size without moving.
+ *
+ * The block keeps its size; the bytes up to expected_max are held as slack that
+ * later mem_resize calls claim in place. This is only a hint: if the room cannot
+ * be found, the block is left as it is.
+ *
+ * @param block Pointer to an allocated block.
+ * @param expected_max Size in bytes the block is expected to grow to.
+ * @return Pointer to the block, which may have moved to find the room.
+ */
+void* mem_resize_hint(void* block, size_t expected_max) {
+    uint64_t start = mem_stats_clock();
+    pool_lock();
+    void* result = block;
+    if (block != NULL && find_huge(block) == NULL && mem_to_offset(block) != MEM_INVALID_OFFSET) {
+        size_t start_index = (char*)block - memory_pool;
+        size_t size = block_size(start_index);
+        if (size != 0 && !pool->ring && !in_page_region(start_index) && expected_max > size + slack_after(start_index + size) && !use_huge_path(expected_max)) {
+            void* moved = reserve_locked(block, size, expected_max);
+            if (moved != NULL) {
+                result = moved;
             }
-        } else {
-            free_blocks = 0; // Reset if block is not free
         }
     }
+    publish_usage_locked();
+    pool_unlock();
+    mem_stats_record(MEM_STATS_RESIZE, start, false);
+    return result;
+}
 
-    // If we reach here, no suitable block was found
-    printf("Not enough contiguous memory available to allocate %zu bytes.\n", size);
-    return NULL;
+/**
+ * @brief Report how many bytes a block can hold without moving.
+ *
+ * @param block Pointer to an allocated block.
+ * @return The block's size plus its slack, or 0 if it is not an allocated block.
+ */
+size_t mem_usable_size(void* block) {
+    pool_lock();
+    size_t usable = 0;
+    HugeBlock *huge = find_huge(block);
+    if (huge != NULL) {
+        usable = huge->mapped_size;
+    } else if (block != NULL && mem_to_offset(block) != MEM_INVALID_OFFSET) {
+        size_t start_index = (char*)block - memory_pool;
+        size_t size = block_size(start_index);
+        usable = size ? size + slack_after(start_index + size) : 0;
+    }
+    pool_unlock();
+    return usable;
 }
 
 /**
- * @brief Free a previously allocated block of memory.
+ * @brief Fill in a snapshot of the pool's statistics.
+ *
+ * @param stats Structure receiving the statistics.
+ */
+void mem_get_stats(MemStats* stats) {
+    if (stats == NULL) {
+        printf("Error: stats pointer is NULL in mem_get_stats.\n");
+        return;
+    }
+    memset(stats, 0, sizeof(MemStats));
+    if (pool == NULL) {
+        return;
+    }
+
+    pool_lock();
+    stats->pool_size = pool_size;
+    stats->metadata_bytes = pool->segment_size - align_up(pool_size, page_size());
+    stats->allocated_bytes = pool->total_allocated_memory - pool->reserved_memory;
+    stats->reserved_bytes = pool->reserved_memory;
+    stats->free_bytes = pool_size - pool->total_allocated_memory;
+    stats->resizes_in_place = pool->resizes_in_place;
+    stats->resizes_moved = pool->resizes_moved;
+
+    // The largest hole takes a pass over the map
+    size_t run = 0;
+    for (size_t i = 0; i < pool_size; i++) {
+        run = allocation_map[i] == BYTE_FREE ? run + 1 : 0;
+        if (run > stats->largest_free_block) {
+            stats->largest_free_block = run;
+        }
+    }
+
+    for (size_t i = 0; i < huge_count; i++) {
+        stats->huge_blocks++;
+        stats->huge_bytes += huge_blocks[i].size;
+    }
+    pool_unlock();
+}
+
+/**
+ * @brief Find the live block containing an arbitrary address.
  *
- * Marks the block as free and updates the allocation maps.
+ * Looks up the nearest block start at or before the address in the ordered
+ * start index, which takes O(log n) word probes instead of walking the map.
  *
- * @param block Pointer to the memory block to free.
+ * @param ptr Any address, typically inside a block.
+ * @param start Receives the start of the containing block; may be NULL.
+ * @param size Receives the size of the containing block; may be NULL.
+ * @return true if ptr lies inside a live block, false otherwise.
  */
-void mem_free(void* block) {
-    if (block == NULL || (char*)block < memory_pool || (char*)block >= memory_pool + pool_size) {
-        printf("Invalid block pointer. It does not belong to the memory pool.\n");
-        return; // Can't free memory outside the pool
+bool mem_find_block(const void* ptr, void** start, size_t* size) {
+    pool_lock();
+    bool found = false;
+    void* block_start = NULL;
+    size_t found_size = 0;
+
+    size_t offset = mem_to_offset(ptr);
+    if (offset != MEM_INVALID_OFFSET) {
+        size_t index = index_pred(0, offset);
+        if (index != NO_BLOCK && offset < index + block_size(index)) {
+            found = true;
+            block_start = memory_pool + index;
+            found_size = block_size(index);
+        }
+    } else {
+        // The registry is ordered by address: only the last mapping starting at or below ptr can hold it
+        const char *p = ptr;
+        size_t slot = huge_slot(p + 1);
+        if (slot > 0 && p < huge_blocks[slot - 1].block + huge_blocks[slot - 1].size) {
+            found = true;
+            block_start = huge_blocks[slot - 1].block;
+            found_size = huge_blocks[slot - 1].size;
+        }
     }
+    pool_unlock();
 
-    size_t start_index = (char*)block - memory_pool; // Calculate the index in the pool
+    if (start != NULL) {
+        *start = block_start;
+    }
+    if (size != NULL) {
+        *size = found_size;
+    }
+    return found;
+}
 
-    if (!allocation_map[start_index]) {
-        printf("Block at index %zu is already free.\n", start_index);
-        return; // Block is already free
+/**
+ * @brief Visit every extent of the pool in address order, then every huge block.
+ *
+ * Live blocks and their slack are stepped over by their recorded sizes and free
+ * runs end at the next block start in the index, so the cost grows with the
+ * number of extents rather than the pool size. The pool is locked for the
+ * whole walk.
+ *
+ * @param callback Function called with each extent; a non-zero return stops the walk.
+ * @param ctx Passed through to the callback.
+ * @return 0 if every extent was visited, otherwise the callback's non-zero value.
+ */
+int mem_walk(mem_walk_fn callback, void* ctx) {
+    if (callback == NULL) {
+        printf("Error: callback is NULL in mem_walk.\n");
+        return -1;
     }
 
-    size_t size = allocation_size_map[start_index];
-    if (size == 0) {
-        printf("No allocation size recorded for block at index %zu.\n", start_index);
-        return; // Inconsistent state
+    pool_lock();
+    int result = 0;
+    MemExtent extent;
+    extent.tag = MEM_TAG_POOL;
+
+    size_t i = 0;
+    while (result == 0 && i < pool_size) {
+        extent.offset = i;
+        extent.address = memory_pool + i;
+
+        if (allocation_map[i] == BYTE_FREE) {
+            // Slack always follows its block, so a free run ends where the next block starts
+            size_t next = index_succ(0, i);
+            extent.state = MEM_EXTENT_FREE;
+            extent.size = (next == NO_BLOCK ? pool_size : next) - i;
+        } else if (allocation_map[i] == BYTE_RESERVED) {
+            extent.state = MEM_EXTENT_RESERVED;
+            extent.size = slack_after(i);
+        } else {
+            extent.state = MEM_EXTENT_ALLOCATED;
+            extent.size = block_size(i);
+        }
+
+        result = callback(&extent, ctx);
+        i += extent.size;
     }
 
-    // Mark the blocks as free
-    for (size_t i = start_index; i < start_index + size; i++) {
-        allocation_map[i] = false;
-        allocation_size_map[i] = 0;
+    extent.tag = MEM_TAG_HUGE;
+    extent.state = MEM_EXTENT_ALLOCATED;
+    extent.offset = MEM_INVALID_OFFSET;
+    for (size_t h = 0; result == 0 && h < huge_count; h++) {
+        extent.address = huge_blocks[h].block;
+        extent.size = huge_blocks[h].size;
+        result = callback(&extent, ctx);
     }
 
-    total_allocated_memory -= size;
-    printf("Memory block freed. Freed %zu bytes. Total allocated: %zu bytes.\n", size, total_allocated_memory);
+    pool_unlock();
+    return result;
 }
 
 /**
- * @brief Resize an allocated memory block.
+ * @brief Start a reachability collection cycle.
  *
- * Attempts to resize the block in place; if not possible, allocates a new block,
- * copies the data, and frees the old block.
+ * Blocks reachable from the roots stay; the sweep frees every other pool block.
+ * Each pointer-sized word of a reached block is treated as a possible pointer, so a
+ * Node's next link, or any other stored pointer into a block, keeps its target alive.
+ * Huge blocks are never freed by the collector and are scanned as extra roots.
+ * Shared pools are not supported, since other processes hold roots this one cannot see.
  *
- * @param block Pointer to the memory block to resize.
- * @param new_size The new size in bytes.
- * @return Pointer to the resized memory block, or NULL if resizing fails.
+ * @param roots Pointers to root blocks, e.g. list heads; NULL entries are skipped.
+ * @param root_count Number of roots.
+ * @return true if the cycle started, false otherwise.
  */
-void* mem_resize(void* block, size_t new_size) {
-    if (block == NULL) {
-        // If block is NULL, behave like mem_alloc
-        return mem_alloc(new_size);
+bool mem_gc_begin(void* const* roots, size_t root_count) {
+    if (roots == NULL && root_count > 0) {
+        printf("Error: roots pointer is NULL in mem_gc_begin.\n");
+        return false;
     }
 
-    if (new_size == 0) {
-        // If new size is zero, free the block
-        mem_free(block);
-        return NULL;
+    pool_lock();
+    if (pool == NULL || pool->shared || gc.phase != GC_IDLE) {
+        printf("Error: Collection needs a private pool with no cycle running in mem_gc_begin.\n");
+        pool_unlock();
+        return false;
     }
 
-    size_t start_index = (char*)block - memory_pool; // Find the block's start index
-    size_t current_size = allocation_size_map[start_index];
+    gc.marks = calloc((pool_size + 63) / 64, sizeof(uint64_t));
+    if (gc.marks == NULL) {
+        printf("Error: Mark bitmap allocation failed in mem_gc_begin.\n");
+        pool_unlock();
+        return false;
+    }
+    gc.phase = GC_MARK;
+    gc.overflow = false;
+    gc.reclaimed_bytes = 0;
+    gc.reclaimed_blocks = 0;
 
-    if (current_size == 0) {
-        printf("No allocation size recorded for block at index %zu.\n", start_index);
-        return NULL; // Can't resize an untracked block
+    for (size_t i = 0; i < root_count; i++) {
+        gc_shade((uintptr_t)roots[i]);
     }
+    for (size_t h = 0; h < huge_count; h++) {
+        gc_push(huge_blocks[h].block);
+    }
+    pool_unlock();
+    return true;
+}
 
-    if (new_size <= current_size) {
-        // Shrinking the block; free the extra space
-        for (size_t i = start_index + new_size; i < start_index + current_size; i++) {
-            allocation_map[i] = false;
-            allocation_size_map[i] = 0;
+/**
+ * @brief Scans queued blocks for at most budget words. The caller holds the pool lock.
+ *
+ * @return Budget left over once the gray stack ran empty and marking is complete.
+ */
+static size_t gc_mark_step(size_t budget) {
+    while (budget > 0) {
+        if (gc.scan_block == NULL) {
+            if (gc.gray_count == 0) {
+                gc.phase = GC_SWEEP;
+                gc.sweep_index = 0;
+                return budget;
+            }
+            gc.scan_block = gc.gray[--gc.gray_count];
+            gc.scan_offset = 0;
         }
-        total_allocated_memory -= (current_size - new_size);
-        allocation_size_map[start_index] = new_size;
 
-        printf("Resized block at index %zu to %zu bytes. Total allocated: %zu bytes.\n", start_index, new_size, total_allocated_memory);
-        return block; // Return the same block since it's resized in place
+        // The block may have shrunk, moved or been freed since the last step
+        size_t size = gc_live_size(gc.scan_block);
+        while (budget > 0 && gc.scan_offset + sizeof(uintptr_t) <= size) {
+            gc_scan_word(gc.scan_block, gc.scan_offset);
+            gc.scan_offset += sizeof(uintptr_t);
+            budget--;
+        }
+        if (gc.scan_offset + sizeof(uintptr_t) > size) {
+            gc.scan_block = NULL;
+        }
     }
+    return 0;
+}
 
-    // Check if we can expand the block in place
-    size_t required_size = new_size - current_size;
-    size_t i;
-    for (i = start_index + current_size; i < start_index + new_size; i++) {
-        if (i >= pool_size || allocation_map[i]) {
-            break; // Can't expand further
+/**
+ * @brief Frees unmarked blocks, visiting at most budget blocks. The caller holds the pool lock.
+ *
+ * @return Budget left over once the sweep reached the end of the pool.
+ */
+static size_t gc_sweep_step(size_t budget) {
+    while (budget > 0) {
+        size_t start = gc.sweep_index < pool_size ? index_succ(0, gc.sweep_index) : NO_BLOCK;
+        if (start == NO_BLOCK) {
+            printf("Collector reclaimed %zu bytes in %zu unreachable blocks. Total allocated: %zu bytes.\n", gc.reclaimed_bytes, gc.reclaimed_blocks, pool->total_allocated_memory);
+            gc_reset();
+            return budget;
         }
-    }
 
-    if (i == start_index + new_size) {
-        // Enough space to expand in place
-        for (size_t j = start_index + current_size; j < start_index + new_size; j++) {
-            allocation_map[j] = true;
+        size_t size = block_size(start);
+        gc.sweep_index = start + size;
+        budget--;
+        if (gc.overflow || (gc.marks[start / 64] >> (start % 64)) & 1) {
+            continue; // Reached, or the marks are incomplete
         }
-        allocation_size_map[start_index] = new_size;
-        total_allocated_memory += (new_size - current_size);
 
-        printf("Expanded block at index %zu to %zu bytes. Total allocated: %zu bytes.\n", start_index, new_size, total_allocated_memory);
-        return block; // Successfully resized in place
+        mem_profile_record_free(memory_pool + start);
+        release_slack(start + size, slack_after(start + size));
+        mark_free(start, size);
+        ring_retire();
+        page_region_shrink();
+        gc.reclaimed_bytes += size;
+        gc.reclaimed_blocks++;
     }
+    return 0;
+}
 
-    // If in-place expansion isn't possible, allocate a new block
-    void* new_block = mem_alloc(new_size);
-    if (new_block) {
-        memcpy(new_block, block, current_size); // Copy existing data to the new block
-        mem_free(block); // Free the old block
+/**
+ * @brief Do a bounded amount of work on the running collection cycle.
+ *
+ * The pool stays usable between steps. Blocks allocated during a cycle survive it and
+ * get scanned, and mem_free scans a block before freeing it, so the list operations,
+ * which unlink a node and then free it, are safe to interleave. Code that moves the
+ * only pointer to a block into another block without freeing the old holder should
+ * finish the cycle first.
+ *
+ * @param budget Words to scan while marking or blocks to visit while sweeping; 0 finishes the cycle.
+ * @return true once no cycle is running any more.
+ */
+bool mem_gc_step(size_t budget) {
+    pool_lock();
+    size_t left = budget == 0 ? SIZE_MAX : budget;
+    if (gc.phase == GC_MARK) {
+        left = gc_mark_step(left);
+    }
+    if (gc.phase == GC_SWEEP && left > 0) {
+        // Blocks waiting in the deferred queue are unmarked but already owned by mem_free;
+        // free them now and keep the queue shut while sweeping, so none is freed twice
+        pthread_mutex_lock(&deferred.lock);
+        deferred_drain_held();
+        gc_sweep_step(left);
+        pthread_mutex_unlock(&deferred.lock);
+    }
+    bool done = gc.phase == GC_IDLE;
+    publish_usage_locked();
+    pool_unlock();
+    return done;
+}
 
-        printf("Resized block by allocating new block of %zu bytes and freeing old block. Total allocated: %zu bytes.\n", new_size, total_allocated_memory);
+/**
+ * @brief Run a whole collection cycle at once.
+ *
+ * @param roots Pointers to root blocks, e.g. list heads; NULL entries are skipped.
+ * @param root_count Number of roots.
+ * @return Bytes freed by the cycle, 0 if it could not start.
+ */
+size_t mem_gc_collect(void* const* roots, size_t root_count) {
+    if (!mem_gc_begin(roots, root_count)) {
+        return 0;
     }
+    mem_gc_step(0);
+    return gc.reclaimed_bytes;
+}
 
-    return new_block; // Return the new block or NULL if allocation failed
+/**
+ * @brief Set the request size from which allocations get a dedicated mapping.
+ *
+ * Such blocks live outside the pool: they never fragment it, and resizing them
+ * remaps pages instead of copying. Shared pools never use this path. The path is
+ * off by default; once enabled, requests at or above the threshold succeed even
+ * when they are larger than the pool, since they do not come from it.
+ *
+ * @param threshold Smallest size in bytes served by mmap; 0, the default, serves everything from the pool.
+ */
+void mem_set_mmap_threshold(size_t threshold) {
+    pool_lock();
+    mmap_threshold = threshold;
+    pool_unlock();
+}
+
+/**
+ * @brief Translate a block pointer into an offset from the pool start.
+ *
+ * Offsets stay valid in every process attached to a shared pool, whatever address it is mapped at.
+ *
+ * @param block Pointer into the memory pool.
+ * @return Offset of the block, or MEM_INVALID_OFFSET if it is not inside the pool.
+ */
+size_t mem_to_offset(const void* block) {
+    if (memory_pool == NULL || (const char*)block < memory_pool || (const char*)block >= memory_pool + pool_size) {
+        return MEM_INVALID_OFFSET;
+    }
+    return (size_t)((const char*)block - memory_pool);
+}
+
+/**
+ * @brief Translate an offset from the pool start back into a pointer in this process.
+ *
+ * @param offset Offset previously returned by mem_to_offset.
+ * @return Pointer into the memory pool, or NULL if the offset is out of range.
+ */
+void* mem_from_offset(size_t offset) {
+    if (memory_pool == NULL || offset >= pool_size) {
+        return NULL;
+    }
+    return memory_pool + offset;
+}
+
+/**
+ * @brief Size of the pool in bytes, without the pass over the map that mem_get_stats makes.
+ *
+ * @return Pool size, or 0 if no pool is initialized.
+ */
+size_t mem_pool_size() {
+    return memory_pool != NULL ? pool_size : 0;
+}
+
+/**
+ * @brief Take the pool lock, e.g. to read state that the recording hooks update under it.
+ *
+ * Does nothing unless the pool is thread safe. Must not be held across calls into the memory manager.
+ */
+void mem_lock() {
+    pool_lock();
+}
+
+/**
+ * @brief Release the pool lock taken with mem_lock.
+ */
+void mem_unlock() {
+    pool_unlock();
 }
 
 /**
  * @brief Deinitialize the memory pool, freeing all allocated resources.
  *
- * Frees the memory pool and allocation maps, resetting all tracking variables.
+ * Unmaps the pool segment and resets all tracking variables. A shared pool is
+ * only detached from this process; see mem_unlink_shared.
  */
 void mem_deinit() {
-    if (memory_pool != NULL) {
-        free(memory_pool);
-        memory_pool = NULL;
-    }
+    mem_set_deferred_free(false, false);
+    gc_reset();
 
-    if (allocation_map != NULL) {
-        free(allocation_map);
-        allocation_map = NULL;
+    // Huge blocks belong to the pool's lifetime too
+    while (huge_count > 0) {
+        huge_free(&huge_blocks[huge_count - 1]);
     }
+    free(huge_blocks);
+    huge_blocks = NULL;
+    huge_capacity = 0;
 
-    if (allocation_size_map != NULL) {
-        free(allocation_size_map);
-        allocation_size_map = NULL;
+    if (segment != NULL) {
+        munmap(segment, pool->segment_size);
     }
 
-    total_allocated_memory = 0;
+    segment = NULL;
+    pool = NULL;
+    memory_pool = NULL;
+    allocation_map = NULL;
+    allocation_size_map = NULL;
     pool_size = 0;
+    stats_scan_index = 0;
+    stats_scan_run = 0;
+    stats_scan_largest = 0;
+    remap_moves = 0;
+    mem_profile_record_reset();
 
     printf("Memory pool deinitialized.\n");
 }
@@ -263,9 +2325,11 @@ void mem_deinit() {
  * Displays a simple binary map where '1' indicates allocated and '0' indicates free.
  */
 void print_allocation_map() {
+    pool_lock();
     printf("Allocation Map: ");
     for (size_t i = 0; i < pool_size; i++) {
         printf("%d", allocation_map[i]);
     }
     printf("\n");
+    pool_unlock();
 }
@@ -2,14 +2,107 @@
 #define MEMORY_MANAGER_H
 
 #include <stddef.h>
+#include <stdbool.h>
+
+#define MEM_INVALID_OFFSET ((size_t)-1) // Returned by mem_to_offset for pointers outside the pool
+
+// Snapshot of the pool filled in by mem_get_stats
+typedef struct {
+    size_t pool_size;           // Total size of the memory pool
+    size_t allocated_bytes;     // Bytes in live blocks
+    size_t reserved_bytes;      // Slack held after blocks for growth
+    size_t free_bytes;          // Bytes available to new blocks
+    size_t largest_free_block;  // Largest contiguous free run
+    size_t huge_blocks;         // Blocks mapped outside the pool
+    size_t huge_bytes;          // Bytes in those blocks
+    size_t resizes_in_place;    // mem_resize calls that kept the block where it was
+    size_t resizes_moved;       // mem_resize calls that moved the data
+    size_t metadata_bytes;      // Header, allocation maps and block index mapped next to the pool
+} MemStats;
+
+// State of an extent reported by mem_walk
+typedef enum {
+    MEM_EXTENT_FREE,            // Available to new blocks
+    MEM_EXTENT_ALLOCATED,       // A live block
+    MEM_EXTENT_RESERVED         // Growth slack of the allocated extent right before it
+} MemExtentState;
+
+// Where an extent lives
+typedef enum {
+    MEM_TAG_POOL,               // Inside the memory pool
+    MEM_TAG_HUGE                // A huge block with a mapping of its own
+} MemExtentTag;
+
+// One extent visited by mem_walk
+typedef struct {
+    size_t offset;              // Offset from the pool start, MEM_INVALID_OFFSET for huge blocks
+    void* address;              // Start of the extent in this process
+    size_t size;                // Length in bytes
+    MemExtentState state;
+    MemExtentTag tag;
+} MemExtent;
+
+// Called for every extent; return non-zero to stop the walk. Must not call back into the memory manager.
+typedef int (*mem_walk_fn)(const MemExtent* extent, void* ctx);
 
 // Function declarations for the memory manager
 
 void mem_init(size_t size);
 void* mem_alloc(size_t size);
+void* mem_alloc_aligned(size_t size, size_t alignment);
 void mem_free(void* block);
 void* mem_resize(void* block, size_t new_size);
 void mem_deinit();
 void print_allocation_map();
 
+// Growth and statistics
+
+void mem_set_growth_policy(bool enabled);
+void* mem_resize_hint(void* block, size_t expected_max);
+size_t mem_usable_size(void* block);
+void mem_get_stats(MemStats* stats);
+int mem_walk(mem_walk_fn callback, void* ctx);
+bool mem_find_block(const void* ptr, void** start, size_t* size);
+
+// Reachability-based reclamation
+
+bool mem_gc_begin(void* const* roots, size_t root_count);
+bool mem_gc_step(size_t budget);
+size_t mem_gc_collect(void* const* roots, size_t root_count);
+
+// Ring allocation for blocks freed in allocation order
+
+void mem_set_ring_mode(bool enabled);
+
+// Threads and reference counting
+
+void mem_set_thread_safe(bool enabled);
+void mem_set_deferred_free(bool enabled, bool zero);
+void mem_flush_deferred();
+void* mem_alloc_rc(size_t size);
+void* mem_retain(void* block);
+size_t mem_release(void* block);
+size_t mem_ref_count(const void* block);
+
+// Page-aligned buffers
+
+void* mem_alloc_pages(size_t n_pages);
+
+// Huge allocations
+
+void mem_set_mmap_threshold(size_t threshold);
+
+// Pools shared between processes
+
+void mem_init_shared(const char* name, size_t size);
+void mem_unlink_shared(const char* name);
+size_t mem_to_offset(const void* block);
+void* mem_from_offset(size_t offset);
+size_t mem_pool_size();
+
+// Pool lock for the profiler and statistics, which keep state the memory manager updates under it
+
+void mem_lock();
+void mem_unlock();
+
 #endif // MEMORY_MANAGER_H
@@ -0,0 +1,134 @@
+#include "mem_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+// mmstat: live view of a process's memory pool, in the style of vmstat.
+//
+// Usage: mmstat <pid | /page-name> [interval seconds] [count]
+
+#define HEADER_EVERY 20 // Rows between repeated headers
+
+// Counters of one sample, copied out of the page
+typedef struct {
+    uint64_t ops[MEM_STATS_OP_COUNT];
+    uint64_t failures;
+    uint64_t latency[MEM_STATS_BUCKETS];
+} Sample;
+
+static void take_sample(const MemStatsPage* page, Sample* sample) {
+    for (int i = 0; i < MEM_STATS_OP_COUNT; i++) {
+        sample->ops[i] = atomic_load_explicit(&page->ops[i], memory_order_relaxed);
+    }
+    sample->failures = atomic_load_explicit(&page->failures, memory_order_relaxed);
+    for (int i = 0; i < MEM_STATS_BUCKETS; i++) {
+        sample->latency[i] = atomic_load_explicit(&page->latency[i], memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Upper bound in ns of the bucket holding the given quantile of the calls between two samples.
+ *
+ * @return The bound, 0 if there were no calls, or UINT64_MAX for the open-ended last bucket.
+ */
+static uint64_t latency_quantile(const Sample* before, const Sample* after, double quantile) {
+    uint64_t total = 0;
+    for (int i = 0; i < MEM_STATS_BUCKETS; i++) {
+        total += after->latency[i] - before->latency[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < MEM_STATS_BUCKETS - 1; i++) {
+        seen += after->latency[i] - before->latency[i];
+        if (seen >= quantile * total) {
+            return mem_stats_bucket_floor(i + 1);
+        }
+    }
+    return UINT64_MAX;
+}
+
+static void print_latency(uint64_t ns) {
+    if (ns == UINT64_MAX) {
+        printf(" %8s", "slow");
+    } else {
+        printf(" %8llu", (unsigned long long)ns);
+    }
+}
+
+static void print_header() {
+    printf("%9s %9s %9s %7s %12s %12s %12s %8s %8s\n",
+           "alloc/s", "free/s", "resize/s", "fail/s", "allocated", "free", "largest", "p50<ns", "p99<ns");
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s <pid | /page-name> [interval seconds] [count]\n", argv[0]);
+        return 1;
+    }
+
+    char name[64];
+    if (argv[1][0] == '/') {
+        snprintf(name, sizeof(name), "%s", argv[1]);
+    } else {
+        snprintf(name, sizeof(name), "%s%s", MEM_STATS_PREFIX, argv[1]);
+    }
+    int interval = argc > 2 ? atoi(argv[2]) : 1;
+    long count = argc > 3 ? atol(argv[3]) : -1; // Run until interrupted by default
+    if (interval <= 0) {
+        printf("Interval must be a positive number of seconds.\n");
+        return 1;
+    }
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd == -1) {
+        printf("No statistics page %s; is the process publishing with mem_stats_publish?\n", name);
+        return 1;
+    }
+    const MemStatsPage* page = mmap(NULL, sizeof(MemStatsPage), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (page == MAP_FAILED || page->magic != MEM_STATS_MAGIC) {
+        printf("Statistics page %s is not ready.\n", name);
+        return 1;
+    }
+    pid_t pid = (pid_t)page->pid;
+
+    Sample before;
+    Sample after;
+    take_sample(page, &before);
+    for (long row = 0; count < 0 || row < count; row++) {
+        if (row % HEADER_EVERY == 0) {
+            print_header();
+        }
+        sleep(interval);
+        if (kill(pid, 0) == -1 && errno == ESRCH) {
+            printf("Process %d has exited.\n", (int)pid);
+            break;
+        }
+
+        take_sample(page, &after);
+        printf("%9llu %9llu %9llu %7llu %12llu %12llu %12llu",
+               (unsigned long long)(after.ops[MEM_STATS_ALLOC] - before.ops[MEM_STATS_ALLOC]) / interval,
+               (unsigned long long)(after.ops[MEM_STATS_FREE] - before.ops[MEM_STATS_FREE]) / interval,
+               (unsigned long long)(after.ops[MEM_STATS_RESIZE] - before.ops[MEM_STATS_RESIZE]) / interval,
+               (unsigned long long)(after.failures - before.failures) / interval,
+               (unsigned long long)atomic_load_explicit(&page->allocated_bytes, memory_order_relaxed),
+               (unsigned long long)atomic_load_explicit(&page->free_bytes, memory_order_relaxed),
+               (unsigned long long)atomic_load_explicit(&page->largest_free_block, memory_order_relaxed));
+        print_latency(latency_quantile(&before, &after, 0.50));
+        print_latency(latency_quantile(&before, &after, 0.99));
+        printf("\n");
+        fflush(stdout);
+        before = after;
+    }
+
+    munmap((void*)page, sizeof(MemStatsPage));
+    return 0;
+}
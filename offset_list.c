@@ -0,0 +1,392 @@
+#include "offset_list.h"
+#include "linked_list.h"
+#include "memory_manager.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief Returns the start of the pool in this process; references are offsets from here.
+ */
+static char* pool_base() {
+    return (char*)mem_from_offset(0);
+}
+
+/**
+ * @brief Resolves a reference that is known to be valid against a cached pool base.
+ */
+static OffsetNode* node_at(char* base, OffsetRef ref) {
+    return (OffsetNode*)(base + ref);
+}
+
+/**
+ * @brief Allocates a node from the pool without letting mem_alloc print debug info.
+ *
+ * @param caller Name of the calling function for error messages.
+ * @return Reference to the new node, or OLIST_NULL on failure.
+ */
+static OffsetRef alloc_node(const char* caller) {
+    // Hide stdout to prevent mem_alloc from printing debug info
+    FILE* saved_stdout = redirect_stdout_to_null();
+    if (saved_stdout == NULL) {
+        printf("Error: Failed to redirect stdout in %s.\n", caller);
+        return OLIST_NULL;
+    }
+
+    void* block = mem_alloc(sizeof(OffsetNode));
+
+    // Restore stdout after allocation
+    restore_stdout_from_null(saved_stdout);
+
+    size_t offset = mem_to_offset(block);
+    if (block == NULL || offset == MEM_INVALID_OFFSET) {
+        printf("Error: Memory allocation failed in %s.\n", caller);
+        return OLIST_NULL;
+    }
+    return (OffsetRef)offset;
+}
+
+/**
+ * @brief Returns a node to the pool without letting mem_free print debug info.
+ */
+static void free_node(char* base, OffsetRef ref) {
+    FILE* saved_stdout = redirect_stdout_to_null();
+    mem_free(node_at(base, ref));
+    restore_stdout_from_null(saved_stdout);
+}
+
+/**
+ * @brief Initializes the list and the memory manager.
+ *
+ * @param list Pointer to the list.
+ * @param size Size of the memory pool in bytes; must fit in 32-bit offsets.
+ */
+void olist_init(OffsetList* list, size_t size) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in olist_init.\n");
+        exit(EXIT_FAILURE); // Can't proceed without a valid list
+    }
+
+    if (size >= OLIST_NULL) {
+        printf("Error: Pool of %zu bytes is too large for 32-bit offsets in olist_init.\n", size);
+        exit(EXIT_FAILURE);
+    }
+
+    // Temporarily hide stdout to prevent mem_init from printing debug info
+    FILE* saved_stdout = redirect_stdout_to_null();
+    if (saved_stdout == NULL) {
+        printf("Error: Failed to redirect stdout in olist_init.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    mem_init(size);
+
+    restore_stdout_from_null(saved_stdout);
+
+    // Start with an empty list
+    list->head = OLIST_NULL;
+    list->tail = OLIST_NULL;
+    list->count = 0;
+}
+
+/**
+ * @brief Resolves a node reference against the current pool mapping.
+ *
+ * @param ref Node reference.
+ * @return Pointer to the node, or NULL for OLIST_NULL or a reference outside the pool.
+ */
+OffsetNode* olist_node(OffsetRef ref) {
+    if (ref == OLIST_NULL) {
+        return NULL;
+    }
+    return (OffsetNode*)mem_from_offset(ref);
+}
+
+/**
+ * @brief Inserts a new node with the specified data at the end of the list in O(1).
+ *
+ * @param list Pointer to the list.
+ * @param data Data to be inserted into the new node.
+ */
+void olist_insert(OffsetList* list, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in olist_insert.\n");
+        return;
+    }
+
+    OffsetRef new_ref = alloc_node("olist_insert");
+    if (new_ref == OLIST_NULL) {
+        return;
+    }
+
+    char* base = pool_base();
+    OffsetNode* new_node = node_at(base, new_ref);
+    new_node->data = data;
+    new_node->next = OLIST_NULL;
+
+    if (list->tail == OLIST_NULL) {
+        // If the list is empty, the new node becomes the head
+        list->head = new_ref;
+    } else {
+        // Otherwise, link the new node after the tail
+        node_at(base, list->tail)->next = new_ref;
+    }
+    list->tail = new_ref;
+    list->count++;
+}
+
+/**
+ * @brief Inserts a new node with the specified data immediately after the given node.
+ *
+ * @param list Pointer to the list holding prev_node.
+ * @param prev_node Reference to the node after which the new node will be inserted.
+ * @param data Data to be inserted into the new node.
+ */
+void olist_insert_after(OffsetList* list, OffsetRef prev_node, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in olist_insert_after.\n");
+        return;
+    }
+
+    if (prev_node == OLIST_NULL) {
+        printf("Error: prev_node is NULL in olist_insert_after.\n");
+        return;
+    }
+
+    OffsetRef new_ref = alloc_node("olist_insert_after");
+    if (new_ref == OLIST_NULL) {
+        return;
+    }
+
+    char* base = pool_base();
+    OffsetNode* prev = node_at(base, prev_node);
+    OffsetNode* new_node = node_at(base, new_ref);
+    new_node->data = data;
+    new_node->next = prev->next;
+    prev->next = new_ref;
+    if (list->tail == prev_node) {
+        list->tail = new_ref;
+    }
+    list->count++;
+}
+
+/**
+ * @brief Inserts a new node with the specified data immediately before the given node.
+ *
+ * @param list Pointer to the list holding next_node.
+ * @param next_node Reference to the node before which the new node will be inserted.
+ * @param data Data to be inserted into the new node.
+ */
+void olist_insert_before(OffsetList* list, OffsetRef next_node, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in olist_insert_before.\n");
+        return;
+    }
+
+    if (next_node == OLIST_NULL) {
+        printf("Error: next_node is NULL in olist_insert_before.\n");
+        return;
+    }
+
+    OffsetRef new_ref = alloc_node("olist_insert_before");
+    if (new_ref == OLIST_NULL) {
+        return;
+    }
+
+    char* base = pool_base();
+    OffsetNode* new_node = node_at(base, new_ref);
+    new_node->data = data;
+
+    if (list->head == next_node) {
+        // If we're inserting before the head, update the head reference
+        new_node->next = list->head;
+        list->head = new_ref;
+        list->count++;
+        return;
+    }
+
+    // Find the node just before next_node
+    OffsetRef current = list->head;
+    while (current != OLIST_NULL && node_at(base, current)->next != next_node) {
+        current = node_at(base, current)->next;
+    }
+
+    if (current == OLIST_NULL) {
+        printf("Error: next_node not found in the list.\n");
+        free_node(base, new_ref); // Can't insert it, so give the node back
+        return;
+    }
+
+    node_at(base, current)->next = new_ref;
+    new_node->next = next_node;
+    list->count++;
+}
+
+/**
+ * @brief Deletes the first node with the specified data from the list.
+ *
+ * @param list Pointer to the list.
+ * @param data Data of the node to be deleted.
+ */
+void olist_delete(OffsetList* list, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in olist_delete.\n");
+        return;
+    }
+
+    if (list->head == OLIST_NULL) {
+        printf("Error: Cannot delete from an empty list.\n");
+        return;
+    }
+
+    char* base = pool_base();
+    OffsetRef current = list->head;
+    OffsetRef prev = OLIST_NULL;
+
+    // Search for the node to delete
+    while (current != OLIST_NULL && node_at(base, current)->data != data) {
+        prev = current;
+        current = node_at(base, current)->next;
+    }
+
+    if (current == OLIST_NULL) {
+        printf("Error: Node with data %u not found in olist_delete.\n", data);
+        return;
+    }
+
+    if (prev == OLIST_NULL) {
+        list->head = node_at(base, current)->next; // Deleting the head
+    } else {
+        node_at(base, prev)->next = node_at(base, current)->next;
+    }
+    if (list->tail == current) {
+        list->tail = prev; // Deleting the tail
+    }
+    list->count--;
+
+    free_node(base, current);
+}
+
+/**
+ * @brief Searches for the first node with the specified data.
+ *
+ * @param list Pointer to the list.
+ * @param data Data to search for.
+ * @return Reference to the found node, or OLIST_NULL if not found.
+ */
+OffsetRef olist_search(OffsetList* list, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in olist_search.\n");
+        return OLIST_NULL;
+    }
+
+    char* base = pool_base();
+    OffsetRef current = list->head;
+    while (current != OLIST_NULL) {
+        OffsetNode* node = node_at(base, current);
+        if (node->data == data) {
+            return current; // Found the node
+        }
+        current = node->next;
+    }
+
+    return OLIST_NULL;
+}
+
+/**
+ * @brief Displays all elements in the list.
+ *
+ * @param list Pointer to the list.
+ */
+void olist_display(OffsetList* list) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in olist_display.\n");
+        return;
+    }
+
+    olist_display_range(list, OLIST_NULL, OLIST_NULL);
+}
+
+/**
+ * @brief Displays elements in the list between two specified nodes.
+ *
+ * @param list Pointer to the list.
+ * @param start_node Starting node (inclusive). If OLIST_NULL, starts from the head.
+ * @param end_node Ending node (inclusive). If OLIST_NULL, ends at the last node.
+ */
+void olist_display_range(OffsetList* list, OffsetRef start_node, OffsetRef end_node) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in olist_display_range.\n");
+        return;
+    }
+
+    char* base = pool_base();
+    printf("[");
+    OffsetRef current = list->head;
+
+    // If a start_node is provided, find it first
+    if (start_node != OLIST_NULL) {
+        while (current != OLIST_NULL && current != start_node) {
+            current = node_at(base, current)->next;
+        }
+    }
+
+    // Now, print nodes until we reach end_node
+    while (current != OLIST_NULL) {
+        OffsetNode* node = node_at(base, current);
+        printf("%u", node->data);
+        if (current == end_node) {
+            break; // Reached the end of the range
+        }
+        if (node->next != OLIST_NULL) {
+            printf(", ");
+        }
+        current = node->next;
+    }
+    printf("]"); // Consistent output formatting
+}
+
+/**
+ * @brief Counts the number of nodes in the list in O(1).
+ *
+ * @param list Pointer to the list.
+ * @return The total number of nodes in the list.
+ */
+size_t olist_count_nodes(OffsetList* list) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in olist_count_nodes.\n");
+        return 0;
+    }
+
+    return list->count;
+}
+
+/**
+ * @brief Frees all nodes and deinitializes the memory manager.
+ *
+ * @param list Pointer to the list.
+ */
+void olist_cleanup(OffsetList* list) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in olist_cleanup.\n");
+        return;
+    }
+
+    char* base = pool_base();
+    OffsetRef current = list->head;
+    while (current != OLIST_NULL) {
+        OffsetRef next = node_at(base, current)->next;
+        free_node(base, current);
+        current = next;
+    }
+
+    // Reset the list
+    list->head = OLIST_NULL;
+    list->tail = OLIST_NULL;
+    list->count = 0;
+
+    // Finally, deinitialize the memory manager
+    FILE* saved_deinit_stdout = redirect_stdout_to_null();
+    mem_deinit();
+    restore_stdout_from_null(saved_deinit_stdout);
+}
@@ -0,0 +1,125 @@
+#ifndef OFFSET_LIST_H
+#define OFFSET_LIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Reference to a node as a 32-bit offset from the start of the memory pool.
+// Unlike raw pointers, references stay valid wherever the pool is mapped.
+typedef uint32_t OffsetRef;
+
+#define OLIST_NULL ((OffsetRef)UINT32_MAX) // Marks the end of the list / an empty list
+
+// Node structure for the relocatable singly linked list (8 bytes)
+typedef struct OffsetNode {
+    uint16_t data;       // Stores the data as an unsigned 16-bit integer
+    OffsetRef next;      // Offset of the next node in the list
+} OffsetNode;
+
+// Handle of a list: both ends as references and the length, so appending and counting need
+// no walk. Like the nodes, the handle stays valid wherever the pool is mapped.
+typedef struct {
+    OffsetRef head;      // First node, OLIST_NULL for an empty list
+    OffsetRef tail;      // Last node, OLIST_NULL for an empty list
+    size_t count;        // Number of nodes
+} OffsetList;
+
+// Initialization function
+/**
+ * @brief Initializes the list and the memory manager.
+ *
+ * @param list Pointer to the list.
+ * @param size Size of the memory pool in bytes; must fit in 32-bit offsets.
+ */
+void olist_init(OffsetList* list, size_t size);
+
+// Reference resolution
+/**
+ * @brief Resolves a node reference against the current pool mapping.
+ *
+ * @param ref Node reference.
+ * @return Pointer to the node, or NULL for OLIST_NULL or a reference outside the pool.
+ */
+OffsetNode* olist_node(OffsetRef ref);
+
+// Insertion functions
+/**
+ * @brief Inserts a new node with the specified data at the end of the list in O(1).
+ *
+ * @param list Pointer to the list.
+ * @param data Data to be inserted into the new node.
+ */
+void olist_insert(OffsetList* list, uint16_t data);
+
+/**
+ * @brief Inserts a new node with the specified data immediately after the given node.
+ *
+ * @param list Pointer to the list holding prev_node.
+ * @param prev_node Reference to the node after which the new node will be inserted.
+ * @param data Data to be inserted into the new node.
+ */
+void olist_insert_after(OffsetList* list, OffsetRef prev_node, uint16_t data);
+
+/**
+ * @brief Inserts a new node with the specified data immediately before the given node.
+ *
+ * @param list Pointer to the list holding next_node.
+ * @param next_node Reference to the node before which the new node will be inserted.
+ * @param data Data to be inserted into the new node.
+ */
+void olist_insert_before(OffsetList* list, OffsetRef next_node, uint16_t data);
+
+// Deletion function
+/**
+ * @brief Deletes the first node with the specified data from the list.
+ *
+ * @param list Pointer to the list.
+ * @param data Data of the node to be deleted.
+ */
+void olist_delete(OffsetList* list, uint16_t data);
+
+// Search function
+/**
+ * @brief Searches for the first node with the specified data.
+ *
+ * @param list Pointer to the list.
+ * @param data Data to search for.
+ * @return Reference to the found node, or OLIST_NULL if not found.
+ */
+OffsetRef olist_search(OffsetList* list, uint16_t data);
+
+// Display functions
+/**
+ * @brief Displays all elements in the list.
+ *
+ * @param list Pointer to the list.
+ */
+void olist_display(OffsetList* list);
+
+/**
+ * @brief Displays elements in the list between two specified nodes.
+ *
+ * @param list Pointer to the list.
+ * @param start_node Starting node (inclusive). If OLIST_NULL, starts from the head.
+ * @param end_node Ending node (inclusive). If OLIST_NULL, ends at the last node.
+ */
+void olist_display_range(OffsetList* list, OffsetRef start_node, OffsetRef end_node);
+
+// Nodes count function
+/**
+ * @brief Counts the number of nodes in the list in O(1).
+ *
+ * @param list Pointer to the list.
+ * @return The total number of nodes in the list.
+ */
+size_t olist_count_nodes(OffsetList* list);
+
+// Cleanup function
+/**
+ * @brief Frees all nodes and deinitializes the memory manager.
+ *
+ * @param list Pointer to the list.
+ */
+void olist_cleanup(OffsetList* list);
+
+#endif // OFFSET_LIST_H
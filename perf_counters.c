@@ -0,0 +1,121 @@
+#include "perf_counters.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define CACHE_READ_MISS(cache) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+// Event type and config for each counter, in PerfCounterId order
+static const struct {
+    uint32_t type;
+    uint64_t config;
+    const char* name;
+} counter_events[PERF_COUNTER_COUNT] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instr"},
+    {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D), "L1D-miss"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "LLC-miss"},
+    {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_DTLB), "dTLB-miss"},
+};
+
+/**
+ * @brief Opens the hardware counters for the calling thread and the threads it creates afterwards.
+ *
+ * @param counters Counter set to initialize.
+ * @return Number of counters that were opened; 0 means only wall-clock time is available.
+ */
+int perf_counters_open(PerfCounters* counters) {
+    int opened = 0;
+
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = counter_events[i].type;
+        attr.config = counter_events[i].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1; // Works with perf_event_paranoid <= 2
+        attr.exclude_hv = 1;
+        attr.inherit = 1;        // Threads created later count into the same totals, e.g. the mt_* workers
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        // Counters are opened one by one so a missing event does not take the others down with it
+        counters->fds[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (counters->fds[i] != -1) {
+            opened++;
+        }
+    }
+
+    return opened;
+}
+
+/**
+ * @brief Resets and enables all open counters.
+ *
+ * @param counters Counter set to start.
+ */
+void perf_counters_start(PerfCounters* counters) {
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (counters->fds[i] != -1) {
+            ioctl(counters->fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(counters->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+/**
+ * @brief Disables all open counters and reads their values, scaled if they were multiplexed.
+ *
+ * @param counters Counter set to stop.
+ * @param sample Receives the counter values.
+ */
+void perf_counters_stop(PerfCounters* counters, PerfSample* sample) {
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        sample->values[i] = 0;
+        sample->valid[i] = false;
+
+        if (counters->fds[i] == -1) {
+            continue;
+        }
+        ioctl(counters->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+        uint64_t data[3]; // value, time enabled, time running
+        if (read(counters->fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0) {
+            continue; // Counter never got scheduled on the PMU
+        }
+
+        // When more counters are open than the PMU has slots, the kernel time-slices them
+        sample->values[i] = data[2] < data[1]
+            ? (uint64_t)((double)data[0] * data[1] / data[2])
+            : data[0];
+        sample->valid[i] = true;
+    }
+}
+
+/**
+ * @brief Closes all open counters.
+ *
+ * @param counters Counter set to close.
+ */
+void perf_counters_close(PerfCounters* counters) {
+    for (int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if (counters->fds[i] != -1) {
+            close(counters->fds[i]);
+            counters->fds[i] = -1;
+        }
+    }
+}
+
+/**
+ * @brief Returns a short column name for a counter.
+ *
+ * @param id Counter to name.
+ * @return Static string with the counter name.
+ */
+const char* perf_counter_name(PerfCounterId id) {
+    return counter_events[id].name;
+}
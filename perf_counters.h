@@ -0,0 +1,69 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Hardware counters collected around each benchmark workload
+typedef enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_DTLB_MISSES,
+    PERF_COUNTER_COUNT
+} PerfCounterId;
+
+// Open counter file descriptors; -1 marks a counter the system does not provide
+typedef struct {
+    int fds[PERF_COUNTER_COUNT];
+} PerfCounters;
+
+// Values read after a workload; valid[i] is false when counter i was unavailable
+typedef struct {
+    uint64_t values[PERF_COUNTER_COUNT];
+    bool valid[PERF_COUNTER_COUNT];
+} PerfSample;
+
+/**
+ * @brief Opens the hardware counters for the calling thread and the threads it creates afterwards.
+ *
+ * Counters that cannot be opened (no PMU, perf_event_paranoid, containers) are skipped.
+ * Open them before any workload starts its threads, or those threads are not counted.
+ *
+ * @param counters Counter set to initialize.
+ * @return Number of counters that were opened; 0 means only wall-clock time is available.
+ */
+int perf_counters_open(PerfCounters* counters);
+
+/**
+ * @brief Resets and enables all open counters.
+ *
+ * @param counters Counter set to start.
+ */
+void perf_counters_start(PerfCounters* counters);
+
+/**
+ * @brief Disables all open counters and reads their values, scaled if they were multiplexed.
+ *
+ * @param counters Counter set to stop.
+ * @param sample Receives the counter values.
+ */
+void perf_counters_stop(PerfCounters* counters, PerfSample* sample);
+
+/**
+ * @brief Closes all open counters.
+ *
+ * @param counters Counter set to close.
+ */
+void perf_counters_close(PerfCounters* counters);
+
+/**
+ * @brief Returns a short column name for a counter.
+ *
+ * @param id Counter to name.
+ * @return Static string with the counter name.
+ */
+const char* perf_counter_name(PerfCounterId id);
+
+#endif // PERF_COUNTERS_H
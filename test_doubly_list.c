@@ -0,0 +1,267 @@
+#include "doubly_list.h"
+#include "memory_manager.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "common_defs.h"
+#include "gitdata.h"
+
+/**
+ * @brief Checks that the prev links mirror the next links and the ends match the list.
+ */
+static void check_links(DList *list, int expected_count)
+{
+    DNode *prev = NULL;
+    int count = 0;
+    for (DNode *node = list->head; node != NULL; node = node->next)
+    {
+        my_assert(node->prev == prev);
+        prev = node;
+        count++;
+    }
+    my_assert(list->tail == prev);
+    my_assert(count == expected_count);
+    my_assert(dlist_count_nodes(list) == (size_t)expected_count);
+}
+
+/**
+ * @brief Captures what a display function prints for the list.
+ */
+static void capture_display(void (*display)(DList *), DList *list, char *buffer, size_t size)
+{
+    memset(buffer, 0, size);
+    FILE *original_stdout = stdout;
+    FILE *fp = tmpfile();
+    my_assert(fp != NULL);
+    stdout = fp;
+    display(list);
+    fflush(fp);
+    stdout = original_stdout;
+    rewind(fp);
+    fread(buffer, 1, size - 1, fp);
+    fclose(fp);
+}
+
+static void display_middle(DList *list)
+{
+    dlist_display_range(list, dlist_search(list, 2), dlist_search(list, 3));
+}
+
+// ********* Test basic doubly linked list operations *********
+
+void test_dlist_init()
+{
+    printf_yellow("  Testing dlist_init ---> ");
+    DList list = {(DNode *)1, (DNode *)1, 1};
+    dlist_init(&list, sizeof(DNode));
+    my_assert(list.head == NULL && list.tail == NULL);
+    my_assert(dlist_count_nodes(&list) == 0);
+    dlist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_dlist_insert()
+{
+    printf_yellow("  Testing dlist_insert, dlist_insert_after and dlist_insert_before ---> ");
+    DList list;
+    dlist_init(&list, sizeof(DNode) * 6);
+    DNode *n20 = dlist_insert(&list, 20);
+    DNode *n40 = dlist_insert(&list, 40);
+    dlist_insert_before(&list, n20, 10); // New head
+    dlist_insert_after(&list, n20, 30);
+    dlist_insert_after(&list, n40, 50);  // New tail
+    my_assert(list.head->data == 10);
+    my_assert(list.tail->data == 50);
+    check_links(&list, 5);
+
+    DNode *node = list.head;
+    for (int value = 10; value <= 50; value += 10)
+    {
+        my_assert(node != NULL && node->data == value);
+        node = node->next;
+    }
+
+    // The pool is full now
+    my_assert(dlist_insert(&list, 60) != NULL);
+    my_assert(dlist_insert(&list, 70) == NULL);
+    check_links(&list, 6);
+
+    dlist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_dlist_remove_and_delete()
+{
+    printf_yellow("  Testing dlist_remove and dlist_delete ---> ");
+    DList list;
+    dlist_init(&list, sizeof(DNode) * 5);
+    DNode *nodes[5];
+    for (int i = 0; i < 5; i++)
+    {
+        nodes[i] = dlist_insert(&list, i);
+    }
+
+    dlist_remove(&list, nodes[2]); // Middle
+    check_links(&list, 4);
+    dlist_remove(&list, nodes[0]); // Head
+    my_assert(list.head == nodes[1]);
+    dlist_remove(&list, nodes[4]); // Tail
+    my_assert(list.tail == nodes[3]);
+    check_links(&list, 2);
+
+    my_assert(dlist_search(&list, 3) == nodes[3]);
+    my_assert(dlist_search(&list, 2) == NULL);
+    dlist_delete(&list, 3);
+    dlist_delete(&list, 1);
+    my_assert(list.head == NULL && list.tail == NULL);
+
+    // Freed nodes are reused
+    my_assert(dlist_insert(&list, 7) != NULL);
+    check_links(&list, 1);
+
+    dlist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_dlist_display()
+{
+    printf_yellow("  Testing dlist_display, dlist_display_reverse and dlist_display_range ---> ");
+    DList list;
+    dlist_init(&list, sizeof(DNode) * 4);
+    for (int value = 1; value <= 4; value++)
+    {
+        dlist_insert(&list, value);
+    }
+
+    char buffer[64];
+    capture_display(dlist_display, &list, buffer, sizeof(buffer));
+    my_assert(strcmp(buffer, "[1, 2, 3, 4]") == 0);
+    capture_display(dlist_display_reverse, &list, buffer, sizeof(buffer));
+    my_assert(strcmp(buffer, "[4, 3, 2, 1]") == 0);
+
+    capture_display(display_middle, &list, buffer, sizeof(buffer));
+    my_assert(strcmp(buffer, "[2, 3]") == 0);
+
+    dlist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+// ********* LRU usage *********
+
+void test_dlist_lru()
+{
+    printf_yellow("  Testing an LRU cache built on dlist_move_to_front ---> ");
+    enum { CAPACITY = 64 };
+    DList list;
+    dlist_init(&list, sizeof(DNode) * CAPACITY);
+    DNode *slots[1024] = {NULL}; // Key -> node, the cache's lookup table
+
+    // Access keys in a pattern with reuse; evict the tail when full
+    int hits = 0;
+    int size = 0;
+    for (int i = 0; i < 10000; i++)
+    {
+        uint16_t key = (uint16_t)((i * 37 + (i / 7) * 11) % 1024);
+        if (i % 3 == 0)
+        {
+            key = (uint16_t)(key % 48); // A hot set that fits in the cache
+        }
+        if (slots[key] != NULL)
+        {
+            dlist_move_to_front(&list, slots[key]);
+            hits++;
+            continue;
+        }
+        if (size == CAPACITY)
+        {
+            DNode *victim = list.tail;
+            slots[victim->data] = NULL;
+            dlist_remove(&list, victim);
+            size--;
+        }
+        DNode *node = list.head != NULL ? dlist_insert_before(&list, list.head, key) : dlist_insert(&list, key);
+        my_assert(node != NULL);
+        slots[key] = node;
+        size++;
+        my_assert(list.head == node);
+    }
+    my_assert(hits > 0);
+    my_assert(dlist_count_nodes(&list) == size);
+    check_links(&list, CAPACITY);
+
+    // Every cached key is in the list exactly once
+    int cached = 0;
+    for (int key = 0; key < 1024; key++)
+    {
+        if (slots[key] != NULL)
+        {
+            my_assert(slots[key]->data == key);
+            cached++;
+        }
+    }
+    my_assert(cached == CAPACITY);
+
+    dlist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+// Main function to run all tests
+int main(int argc, char *argv[])
+{
+#ifdef VERSION
+    printf("Build Version; %s \n", VERSION);
+#endif
+    printf("Git Version; %s/%s \n", git_date, git_sha);
+    if (argc < 2)
+    {
+        printf("Usage: %s <test function>\n", argv[0]);
+        printf("Available test functions:\n");
+        printf("Basic Operations:\n");
+        printf(" 1. test_dlist_init - Initialize the doubly linked list\n");
+        printf(" 2. test_dlist_insert - Test the insert operations\n");
+        printf(" 3. test_dlist_remove_and_delete - Test removing nodes and deleting by value\n");
+        printf(" 4. test_dlist_display - Test displaying forwards, backwards and a range\n");
+
+        printf("\nLRU Usage:\n");
+        printf(" 5. test_dlist_lru - Test an LRU cache that moves hits to the front\n");
+        printf(" 0. Run all tests\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case -1:
+        printf("No tests will be executed.\n");
+        break;
+    case 0:
+        printf("Testing Basic Operations:\n");
+        test_dlist_init();
+        test_dlist_insert();
+        test_dlist_remove_and_delete();
+        test_dlist_display();
+
+        printf("\nTesting LRU Usage:\n");
+        test_dlist_lru();
+        break;
+    case 1:
+        test_dlist_init();
+        break;
+    case 2:
+        test_dlist_insert();
+        break;
+    case 3:
+        test_dlist_remove_and_delete();
+        break;
+    case 4:
+        test_dlist_display();
+        break;
+    case 5:
+        test_dlist_lru();
+        break;
+    default:
+        printf("Invalid test function\n");
+        break;
+    }
+
+    return 0;
+}
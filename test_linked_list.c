@@ -1,4 +1,5 @@
 #include "linked_list.h"
+#include "memory_manager.h"
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
@@ -9,7 +10,7 @@
 #include "gitdata.h"
 
 // Function to capture stdout output.
-void capture_stdout(char *buffer, size_t size, void (*func)(Node **, Node *, Node *), Node **head, Node *start_node, Node *end_node)
+void capture_stdout(char *buffer, size_t size, void (*func)(List *, Node *, Node *), List *list, Node *start_node, Node *end_node)
 {
     // Save the original stdout
     FILE *original_stdout = stdout;
@@ -26,7 +27,7 @@ void capture_stdout(char *buffer, size_t size, void (*func)(Node **, Node *, Nod
     stdout = fp;
 
     // Call the function whose output we want to capture
-    func(head, start_node, end_node);
+    func(list, start_node, end_node);
 
     // Flush the output to the temporary file
     fflush(fp);
@@ -50,99 +51,99 @@ void capture_stdout(char *buffer, size_t size, void (*func)(Node **, Node *, Nod
 void test_list_init()
 {
     printf_yellow("  Testing list_init ---> ");
-    Node *head = NULL;
-    list_init(&head, sizeof(Node));
-    my_assert(head == NULL);
-    list_cleanup(&head);
+    List list;
+    list_init(&list, sizeof(Node));
+    my_assert(list.head == NULL);
+    list_cleanup(&list);
     printf_green("[PASS].\n");
 }
 
 void test_list_insert()
 {
     printf_yellow("  Testing list_insert ---> ");
-    Node *head = NULL;
-    list_init(&head, sizeof(Node) * 2);
-    list_insert(&head, 10);
-    list_insert(&head, 20);
-    my_assert(head->data == 10);
-    my_assert(head->next->data == 20);
-    list_cleanup(&head);
+    List list;
+    list_init(&list, sizeof(Node) * 2);
+    list_insert(&list, 10);
+    list_insert(&list, 20);
+    my_assert(list.head->data == 10);
+    my_assert(list.head->next->data == 20);
+    list_cleanup(&list);
     printf_green("[PASS].\n");
 }
 
 void test_list_insert_after()
 {
     printf_yellow("  Testing list_insert_after ---> ");
-    Node *head = NULL;
-    list_init(&head, sizeof(Node) * 3);
-    list_insert(&head, 10);
-    Node *node = head;
-    list_insert_after(node, 20);
+    List list;
+    list_init(&list, sizeof(Node) * 3);
+    list_insert(&list, 10);
+    Node *node = list.head;
+    list_insert_after(&list, node, 20);
     my_assert(node->next->data == 20);
 
-    list_cleanup(&head);
+    list_cleanup(&list);
     printf_green("[PASS].\n");
 }
 
 void test_list_insert_before()
 {
     printf_yellow("  Testing list_insert_before ---> ");
-    Node *head = NULL;
-    list_init(&head, sizeof(Node) * 3);
-    list_insert(&head, 10);
-    list_insert(&head, 30);
-    Node *node = head->next; // Node with data 30
-    list_insert_before(&head, node, 20);
-    my_assert(head->next->data == 20);
-
-    list_cleanup(&head);
+    List list;
+    list_init(&list, sizeof(Node) * 3);
+    list_insert(&list, 10);
+    list_insert(&list, 30);
+    Node *node = list.head->next; // Node with data 30
+    list_insert_before(&list, node, 20);
+    my_assert(list.head->next->data == 20);
+
+    list_cleanup(&list);
     printf_green("[PASS].\n");
 }
 
 void test_list_delete()
 {
     printf_yellow("  Testing list_delete ---> ");
-    Node *head = NULL;
-    list_init(&head, sizeof(Node) * 2);
-    list_insert(&head, 10);
-    list_insert(&head, 20);
-    list_delete(&head, 10);
-    my_assert(head->data == 20);
-    list_delete(&head, 20);
-    my_assert(head == NULL);
-
-    list_cleanup(&head);
+    List list;
+    list_init(&list, sizeof(Node) * 2);
+    list_insert(&list, 10);
+    list_insert(&list, 20);
+    list_delete(&list, 10);
+    my_assert(list.head->data == 20);
+    list_delete(&list, 20);
+    my_assert(list.head == NULL);
+
+    list_cleanup(&list);
     printf_green("[PASS].\n");
 }
 
 void test_list_search()
 {
     printf_yellow("  Testing list_search ---> ");
-    Node *head = NULL;
-    list_init(&head, sizeof(Node) * 2);
-    list_insert(&head, 10);
-    list_insert(&head, 20);
-    Node *found = list_search(&head, 10);
+    List list;
+    list_init(&list, sizeof(Node) * 2);
+    list_insert(&list, 10);
+    list_insert(&list, 20);
+    Node *found = list_search(&list, 10);
     my_assert(found->data == 10);
 
-    Node *not_found = list_search(&head, 30);
+    Node *not_found = list_search(&list, 30);
     my_assert(not_found == NULL);
 
-    list_cleanup(&head);
+    list_cleanup(&list);
     printf_green("[PASS].\n");
 }
 
 void test_list_display()
 {
     printf_yellow("  Testing list_display ... \n");
-    Node *head = NULL;
+    List list;
 
     int Nnodes = 5 + rand() % 5;
 #ifdef DEBUG
     printf_yellow("   Testing %d nodes.\n", Nnodes);
 #endif
 
-    list_init(&head, sizeof(Node) * Nnodes);
+    list_init(&list, sizeof(Node) * Nnodes);
 
     int randomLow = rand() % Nnodes;
 
@@ -180,15 +181,15 @@ void test_list_display()
     for (int k = 0; k < Nnodes; k++)
     {
         values[k] = 10 + rand() % 90;
-        list_insert(&head, values[k]);
+        list_insert(&list, values[k]);
         if (k == randomLow && !Low)
         {
-            Low = list_search(&head, values[k]);
+            Low = list_search(&list, values[k]);
             sprintf(LowValue, "%d", values[k]);
         }
         if (k == randomHigh && !High)
         {
-            High = list_search(&head, values[k]);
+            High = list_search(&list, values[k]);
             sprintf(HighValue, "%d", values[k]);
         }
         sprintf(stringFull + strlen(stringFull), "%d", values[k]);
@@ -291,59 +292,61 @@ void test_list_display()
     char buffer[1024] = {0}; // Buffer to capture the output
 
     // Test case 1: Displaying full list
-    capture_stdout(buffer, sizeof(buffer), (void (*)(Node **, Node *, Node *))list_display_range, &head, NULL, NULL);
+    capture_stdout(buffer, sizeof(buffer), list_display_range, &list, NULL, NULL);
     my_assert(strcmp(buffer, stringFull) == 0);
     printf("\tFull list: %s\n", buffer);
 
     // Test case 2: Displaying list from second node to end
     memset(buffer, 0, sizeof(buffer)); // Clear buffer
-    capture_stdout(buffer, sizeof(buffer), (void (*)(Node **, Node *, Node *))list_display_range, &head, head->next, NULL);
+    capture_stdout(buffer, sizeof(buffer), list_display_range, &list, list.head->next, NULL);
     my_assert(strcmp(buffer, string2Last) == 0);
     printf("\tFrom second node to end: %s\n", buffer);
 
     // Test case 3: Displaying list from first node to third node
     memset(buffer, 0, sizeof(buffer)); // Clear buffer
-    capture_stdout(buffer, sizeof(buffer), (void (*)(Node **, Node *, Node *))list_display_range, &head, head, head->next->next);
+    capture_stdout(buffer, sizeof(buffer), list_display_range, &list, list.head, list.head->next->next);
     my_assert(strcmp(buffer, string1third) == 0);
     printf("\tFrom first node to third node: %s\n", buffer);
 
     // Test case 4: Displaying random nodes
     memset(buffer, 0, sizeof(buffer)); // Clear buffer
-    capture_stdout(buffer, sizeof(buffer), (void (*)(Node **, Node *, Node *))list_display_range, &head, Low, High);
+    capture_stdout(buffer, sizeof(buffer), list_display_range, &list, Low, High);
     my_assert(strcmp(buffer, stringRandom) == 0);
     printf("\tK random node(s): %s\n", buffer);
 
-    list_cleanup(&head);
+    list_cleanup(&list);
     printf_green("  ... [PASS].\n");
 }
 
 void test_list_count_nodes()
 {
     printf_yellow("  Testing list_count_nodes ---> ");
-    Node *head = NULL;
-    list_init(&head, sizeof(Node) * 3);
-    list_insert(&head, 10);
-    list_insert(&head, 20);
-    list_insert(&head, 30);
+    List list;
+    list_init(&list, sizeof(Node) * 3);
+    list_insert(&list, 10);
+    list_insert(&list, 20);
+    list_insert(&list, 30);
 
-    int count = list_count_nodes(&head);
+    size_t count = list_count_nodes(&list);
     my_assert(count == 3);
+    list_delete(&list, 20);
+    my_assert(list_count_nodes(&list) == 2);
 
-    list_cleanup(&head);
+    list_cleanup(&list);
     printf_green("[PASS].\n");
 }
 
 void test_list_cleanup()
 {
     printf_yellow("  Testing list_cleanup ---> ");
-    Node *head = NULL;
-    list_init(&head, sizeof(Node) * 3);
-    list_insert(&head, 10);
-    list_insert(&head, 20);
-    list_insert(&head, 30);
-
-    list_cleanup(&head);
-    my_assert(head == NULL);
+    List list;
+    list_init(&list, sizeof(Node) * 3);
+    list_insert(&list, 10);
+    list_insert(&list, 20);
+    list_insert(&list, 30);
+
+    list_cleanup(&list);
+    my_assert(list.head == NULL);
     printf_green("[PASS].\n");
 }
 
@@ -352,38 +355,38 @@ void test_list_cleanup()
 void test_list_insert_loop(int count)
 {
     printf_yellow("  Testing list_insert loop ---> ");
-    Node *head = NULL;
-    list_init(&head, sizeof(Node) * count);
+    List list;
+    list_init(&list, sizeof(Node) * count);
     for (int i = 0; i < count; i++)
     {
-        list_insert(&head, i);
+        list_insert(&list, i);
     }
 
-    Node *current = head;
+    Node *current = list.head;
     for (int i = 0; i < count; i++)
     {
         my_assert(current->data == i);
         current = current->next;
     }
 
-    list_cleanup(&head);
+    list_cleanup(&list);
     printf_green("[PASS].\n");
 }
 
 void test_list_insert_after_loop(int count)
 {
     printf_yellow("  Testing list_insert_after loop ---> ");
-    Node *head = NULL;
-    list_init(&head, sizeof(Node) * (count + 1));
-    list_insert(&head, 12345);
+    List list;
+    list_init(&list, sizeof(Node) * (count + 1));
+    list_insert(&list, 12345);
 
-    Node *node = list_search(&head, 12345);
+    Node *node = list_search(&list, 12345);
     for (int i = 0; i < count; i++)
     {
-        list_insert_after(node, i);
+        list_insert_after(&list, node, i);
     }
 
-    Node *current = head;
+    Node *current = list.head;
     my_assert(current->data == 12345);
     current = current->next;
 
@@ -393,82 +396,302 @@ void test_list_insert_after_loop(int count)
         current = current->next;
     }
 
-    list_cleanup(&head);
+    list_cleanup(&list);
     printf_green("[PASS].\n");
 }
 
 void test_list_delete_loop(int count)
 {
     printf_yellow("  Testing list_delete loop ---> ");
-    Node *head = NULL;
-    list_init(&head, sizeof(Node) * count);
+    List list;
+    list_init(&list, sizeof(Node) * count);
     for (int i = 0; i < count; i++)
     {
-        list_insert(&head, i);
+        list_insert(&list, i);
     }
 
     for (int i = 0; i < count; i++)
     {
-        list_delete(&head, i);
+        list_delete(&list, i);
     }
 
-    my_assert(head == NULL);
+    my_assert(list.head == NULL);
 
-    list_cleanup(&head);
+    list_cleanup(&list);
     printf_green("[PASS].\n");
 }
 
 void test_list_search_loop(int count)
 {
     printf_yellow("  Testing list_search loop ---> ");
-    Node *head = NULL;
-    list_init(&head, sizeof(Node) * count);
+    List list;
+    list_init(&list, sizeof(Node) * count);
     for (int i = 0; i < count; i++)
     {
-        list_insert(&head, i);
+        list_insert(&list, i);
     }
 
     for (int i = 0; i < count; i++)
     {
-        Node *found = list_search(&head, i);
+        Node *found = list_search(&list, i);
         my_assert(found->data == i);
     }
 
-    list_cleanup(&head);
+    list_cleanup(&list);
     printf_green("[PASS].\n");
 }
 
 void test_list_edge_cases()
 {
     printf_yellow("  Testing list edge cases ---> ");
-    Node *head = NULL;
-    list_init(&head, sizeof(Node) * 3);
+    List list;
+    list_init(&list, sizeof(Node) * 3);
 
     // Insert at head
-    list_insert(&head, 10);
-    my_assert(head->data == 10);
+    list_insert(&list, 10);
+    my_assert(list.head->data == 10);
 
     // Insert after
-    Node *node = list_search(&head, 10);
-    list_insert_after(node, 20);
+    Node *node = list_search(&list, 10);
+    list_insert_after(&list, node, 20);
     my_assert(node->next->data == 20);
+    my_assert(list.tail == node->next);
 
     // Insert before
-    list_insert_before(&head, node, 15);
+    list_insert_before(&list, node, 15);
 
-    my_assert(head->data == 15);
-    my_assert(head->next->data == 10);
-    my_assert(head->next->next->data == 20);
+    my_assert(list.head->data == 15);
+    my_assert(list.head->next->data == 10);
+    my_assert(list.head->next->next->data == 20);
 
     // Delete
-    list_delete(&head, 15);
+    list_delete(&list, 15);
     my_assert(node->next->data == 20);
 
     // Search
-    Node *found = list_search(&head, 20);
+    Node *found = list_search(&list, 20);
     my_assert(found->data == 20);
 
-    list_cleanup(&head);
+    // Deleting the tail moves it back
+    list_delete(&list, 20);
+    my_assert(list.tail == node);
+    my_assert(list_count_nodes(&list) == 1);
+    list_delete(&list, 10);
+    my_assert(list.head == NULL && list.tail == NULL);
+
+    list_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_list_append_large(int count)
+{
+    printf_yellow("  Testing list_insert appending %d nodes ---> ", count);
+    List list;
+    list_init(&list, sizeof(Node) * count);
+    for (int i = 0; i < count; i++)
+    {
+        list_insert(&list, (uint16_t)i);
+        my_assert(list.tail->data == (uint16_t)i);
+        my_assert(list_count_nodes(&list) == (size_t)i + 1);
+    }
+    my_assert(list.tail->next == NULL);
+
+    list_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+// ********* Reclamation *********
+
+void test_list_reclaim()
+{
+    printf_yellow("  Testing list_reclaim ---> ");
+    List lists[2];
+    list_init(&lists[0], sizeof(Node) * 6);
+    for (int value = 1; value <= 4; value++)
+    {
+        list_insert(&lists[0], value);
+    }
+    List *other = &lists[1];
+    other->head = other->tail = NULL;
+    other->count = 0;
+    other->presence = NULL;
+    other->index = NULL;
+    list_insert(other, 100);
+    list_insert(other, 200);
+
+    // Lose node 2 the way a buggy error path would: unlinked but never freed
+    Node *lost = lists[0].head->next;
+    lists[0].head->next = lost->next;
+
+    // The pool is full until the lost node comes back; the count is fixed up too
+    my_assert(list_reclaim(lists, 2) == sizeof(Node));
+    my_assert(list_count_nodes(&lists[0]) == 3);
+    my_assert(list_count_nodes(other) == 2);
+    my_assert(list_search(other, 200) != NULL);
+
+    list_insert(&lists[0], 5);
+    my_assert(list_search(&lists[0], 5) == lists[0].tail);
+    my_assert(list_reclaim(lists, 2) == 0);
+    my_assert(list_count_nodes(&lists[0]) == 4);
+
+    // Clean up the second list by hand; list_cleanup also tears down the pool
+    Node *current = other->head;
+    while (current != NULL)
+    {
+        Node *next = current->next;
+        mem_free(current);
+        current = next;
+    }
+    list_cleanup(&lists[0]);
+    printf_green("[PASS].\n");
+}
+
+// ********* Value index *********
+
+/**
+ * @brief Returns the first node with the given data by walking the list, bypassing any index.
+ */
+static Node *walk_search(List *list, uint16_t data)
+{
+    for (Node *current = list->head; current != NULL; current = current->next)
+    {
+        if (current->data == data)
+        {
+            return current;
+        }
+    }
+    return NULL;
+}
+
+static Node *node_at(List *list, int position)
+{
+    Node *current = list->head;
+    while (position-- > 0)
+    {
+        current = current->next;
+    }
+    return current;
+}
+
+#define MODEL_VALUES 32 // Few values, so most of them repeat
+
+/**
+ * @brief Applies random inserts and deletes, checking after each that every search finds what a walk would.
+ */
+static void check_lookups_against_walk(List *list, int count)
+{
+    for (int step = 0; step < count; step++)
+    {
+        uint16_t value = (uint16_t)(rand() % MODEL_VALUES);
+        int size = (int)list_count_nodes(list);
+        int op = size == 0 ? 0 : rand() % 4;
+        if (op == 0 && size < count)
+        {
+            list_insert(list, value);
+        }
+        else if (op == 1 && size < count)
+        {
+            list_insert_after(list, node_at(list, rand() % size), value);
+        }
+        else if (op == 2 && size < count)
+        {
+            list_insert_before(list, node_at(list, rand() % size), value);
+        }
+        else if (walk_search(list, value) != NULL)
+        {
+            list_delete(list, value);
+        }
+
+        // Lookups must give the first occurrence, or NULL, as a walk would
+        for (uint16_t v = 0; v <= MODEL_VALUES; v++)
+        {
+            my_assert(list_search(list, v) == walk_search(list, v));
+        }
+        my_assert(list->tail == node_at(list, (int)list_count_nodes(list) - 1) || list->head == NULL);
+    }
+}
+
+void test_list_index(int count)
+{
+    printf_yellow("  Testing list_search and list_delete through the value index ---> ");
+    List list;
+    list_init(&list, sizeof(Node) * count);
+    for (int i = 0; i < count / 4; i++)
+    {
+        list_insert(&list, (uint16_t)(rand() % MODEL_VALUES));
+    }
+
+    // Enabling indexes what is already there
+    my_assert(list_enable_index(&list));
+    my_assert(list.index != NULL && list.presence != NULL);
+
+    check_lookups_against_walk(&list, count);
+
+    list_disable_index(&list);
+    my_assert(list.index == NULL);
+    my_assert(list_search(&list, list.head->data) == list.head);
+
+    list_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_list_presence(int count)
+{
+    printf_yellow("  Testing lookups of absent values with the presence bitmap ---> ");
+    List list;
+    list_init(&list, sizeof(Node) * count);
+    list_insert(&list, 7);
+    list_insert(&list, 7);
+    list_insert(&list, 9);
+    my_assert(list_enable_presence(&list));
+    my_assert(list.index == NULL); // The bitmap works on its own
+
+    my_assert(list_search(&list, 8) == NULL);
+    FILE *saved_stdout = redirect_stdout_to_null();
+    list_delete(&list, 8); // Absent: reported, nothing changes
+    restore_stdout_from_null(saved_stdout);
+    my_assert(list_count_nodes(&list) == 3);
+
+    // The bit stays set until the last copy goes
+    list_delete(&list, 7);
+    my_assert(list_search(&list, 7) == list.head);
+    list_delete(&list, 7);
+    my_assert(list_search(&list, 7) == NULL);
+    my_assert(list_search(&list, 9) == list.head);
+
+    check_lookups_against_walk(&list, count);
+
+    list_disable_presence(&list);
+    my_assert(list.presence == NULL);
+
+    list_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_list_search_loop_indexed(int count)
+{
+    printf_yellow("  Testing list_search loop over %d nodes with the value index ---> ", count);
+    List list;
+    list_init(&list, sizeof(Node) * count);
+    my_assert(list_enable_index(&list));
+    for (int i = 0; i < count; i++)
+    {
+        list_insert(&list, (uint16_t)i);
+    }
+
+    // Values wrap past 65535, and each search finds the first copy
+    for (int i = 0; i < count; i++)
+    {
+        Node *found = list_search(&list, (uint16_t)i);
+        my_assert(found != NULL && found->data == (uint16_t)i);
+    }
+    my_assert(list_search(&list, 0) == list.head);
+
+    // Deleting the head value keeps the index on the following nodes valid
+    list_delete(&list, 0);
+    my_assert(list_search(&list, 1) == list.head);
+
+    list_cleanup(&list);
     printf_green("[PASS].\n");
 }
 
@@ -502,6 +725,15 @@ int main(int argc, char *argv[])
         printf(" 12. test_list_delete_loop - Test multiple detelions\n");
         printf(" 13. test_list_search_loop - Test multiple search\n");
         printf(" 14. test_list_edge_cases - Test edge cases\n");
+        printf(" 16. test_list_append_large - Test appending 10000 nodes through the tail pointer\n");
+
+        printf("\nReclamation:\n");
+        printf(" 15. test_list_reclaim - Test freeing nodes no list can reach\n");
+
+        printf("\nValue Index:\n");
+        printf(" 17. test_list_index - Test that indexed searches and deletes match a walk\n");
+        printf(" 18. test_list_search_loop_indexed - Test searching 1000000 nodes through the index\n");
+        printf(" 19. test_list_presence - Test that absent values are found missing without a walk\n");
         printf(" 0. Run all tests\n");
         return 1;
     }
@@ -529,6 +761,15 @@ int main(int argc, char *argv[])
         test_list_delete_loop(1000);
         test_list_search_loop(1000);
         test_list_edge_cases();
+        test_list_append_large(10000);
+
+        printf("\nTesting Reclamation:\n");
+        test_list_reclaim();
+
+        printf("\nTesting Value Index:\n");
+        test_list_index(2000);
+        test_list_search_loop_indexed(1000000);
+        test_list_presence(2000);
         break;
     case 1:
         test_list_init();
@@ -573,6 +814,21 @@ int main(int argc, char *argv[])
     case 14:
         test_list_edge_cases();
         break;
+    case 15:
+        test_list_reclaim();
+        break;
+    case 16:
+        test_list_append_large(10000);
+        break;
+    case 17:
+        test_list_index(2000);
+        break;
+    case 18:
+        test_list_search_loop_indexed(1000000);
+        break;
+    case 19:
+        test_list_presence(2000);
+        break;
 
     default:
         printf("Invalid test function\n");
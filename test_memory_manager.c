@@ -3,8 +3,19 @@
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
 #include "common_defs.h"
+#include "mem_profile.h"
+#include "mem_stats.h"
+#include "mem_io.h"
 
 #include "gitdata.h"
 
@@ -207,6 +218,35 @@ void test_memory_reuse()
     printf_green("[PASS].\n");
 }
 
+void test_first_fit_hint()
+{
+    printf_yellow("  Testing first fit past a fully allocated prefix ---> ");
+    enum { BLOCKS = 2000 };
+    static char *blocks[BLOCKS];
+    mem_init(BLOCKS * 16);
+    for (int i = 0; i < BLOCKS; i++)
+    {
+        blocks[i] = mem_alloc(16);
+        my_assert(blocks[i] != NULL);
+        my_assert(i == 0 || blocks[i] == blocks[i - 1] + 16); // Each search starts past the full prefix
+    }
+    my_assert(mem_alloc(16) == NULL);
+
+    // Freeing below the prefix pulls the search back: the lowest hole wins
+    mem_free(blocks[BLOCKS / 2]);
+    mem_free(blocks[BLOCKS / 4]);
+    my_assert(mem_alloc(16) == blocks[BLOCKS / 4]);
+    my_assert(mem_alloc(16) == blocks[BLOCKS / 2]);
+
+    // A failed search for a larger block must not skip the small hole it passed
+    mem_free(blocks[10]);
+    my_assert(mem_alloc(32) == NULL);
+    my_assert(mem_alloc(16) == blocks[10]);
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
 void test_block_merging()
 {
     printf_yellow("  Testing block merging ---> ");
@@ -326,6 +366,997 @@ void test_edge_case_allocations()
     printf_green("[PASS].\n");
 }
 
+void test_profile_sampling()
+{
+    printf_yellow("  Testing sampled heap profile ---> ");
+    mem_init(1024);
+    mem_profile_start(1); // Sample every allocation so the totals are exact
+
+    void *block1 = mem_alloc(100);
+    void *block2 = mem_alloc(300);
+    my_assert(block1 != NULL && block2 != NULL);
+
+    char buffer[4096] = {0};
+    FILE *fp = tmpfile();
+    my_assert(fp != NULL);
+    my_assert(mem_profile_dump(fp) >= 1);
+    rewind(fp);
+
+    // Every folded line ends with the live byte count of its call site
+    size_t total = 0;
+    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+    {
+        my_assert(strstr(buffer, "mem_alloc") != NULL);
+        total += strtoul(strrchr(buffer, ' ') + 1, NULL, 10);
+    }
+    fclose(fp);
+    my_assert(total == 400);
+
+    mem_free(block1);
+    mem_free(block2);
+
+    fp = tmpfile();
+    my_assert(fp != NULL);
+    my_assert(mem_profile_dump(fp) == 0); // Nothing sampled is alive anymore
+    fclose(fp);
+    mem_profile_stop();
+
+    // Blocks of one interval or more are always sampled, at their own size
+    mem_profile_start(256);
+    void *large[3];
+    for (int i = 0; i < 3; i++)
+    {
+        large[i] = mem_alloc(300);
+    }
+    fp = tmpfile();
+    my_assert(fp != NULL);
+    my_assert(mem_profile_dump(fp) >= 1);
+    rewind(fp);
+    total = 0;
+    while (fgets(buffer, sizeof(buffer), fp) != NULL)
+    {
+        total += strtoul(strrchr(buffer, ' ') + 1, NULL, 10);
+    }
+    fclose(fp);
+    my_assert(total == 900);
+    for (int i = 0; i < 3; i++)
+    {
+        mem_free(large[i]);
+    }
+
+    mem_profile_stop();
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_shared_pool()
+{
+    printf_yellow("  Testing pool shared between processes ---> ");
+    const char *name = "/test_memory_manager_pool";
+    mem_unlink_shared(name); // Remove leftovers from an aborted run
+    mem_init_shared(name, 4096);
+
+    char *block1 = mem_alloc(100);
+    my_assert(block1 != NULL);
+    strcpy(block1, "from parent");
+    size_t offset1 = mem_to_offset(block1);
+    my_assert(mem_from_offset(offset1) == block1);
+
+    int fds[2];
+    my_assert(pipe(fds) == 0);
+
+    pid_t pid = fork();
+    my_assert(pid >= 0);
+    if (pid == 0)
+    {
+        // Re-attach with the page of the old block taken so the pool lands somewhere else
+        mem_deinit();
+        void *old_page = (void *)((uintptr_t)block1 & ~(uintptr_t)(getpagesize() - 1));
+        void *filler = mmap(old_page, 4096, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+        if (filler == MAP_FAILED)
+        {
+            _exit(2);
+        }
+        mem_init_shared(name, 4096);
+
+        char *seen = mem_from_offset(offset1);
+        char *block2 = mem_alloc(100);
+        if (seen == NULL || seen == block1 || strcmp(seen, "from parent") != 0 || block2 == NULL)
+        {
+            _exit(1);
+        }
+        strcpy(block2, "from child");
+        size_t offset2 = mem_to_offset(block2);
+        write(fds[1], &offset2, sizeof(offset2));
+        mem_deinit();
+        munmap(filler, 4096);
+        _exit(0);
+    }
+
+    int status = 0;
+    size_t offset2 = MEM_INVALID_OFFSET;
+    my_assert(read(fds[0], &offset2, sizeof(offset2)) == sizeof(offset2));
+    my_assert(waitpid(pid, &status, 0) == pid);
+    my_assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    close(fds[0]);
+    close(fds[1]);
+
+    // The child's allocation is visible here and did not overlap ours
+    char *block2 = mem_from_offset(offset2);
+    my_assert(block2 != NULL && strcmp(block2, "from child") == 0);
+    my_assert(offset2 >= offset1 + 100);
+
+    mem_free(block2);
+    mem_free(block1);
+    mem_deinit();
+    mem_unlink_shared(name);
+    printf_green("[PASS].\n");
+}
+
+void test_huge_allocation()
+{
+    printf_yellow("  Testing huge allocations outside the pool ---> ");
+    mem_init(1024);
+    my_assert(mem_alloc(8192) == NULL); // Off by default: larger than the pool still fails
+    mem_set_mmap_threshold(4096);
+
+    char *huge = mem_alloc(8192);
+    my_assert(huge != NULL);
+    my_assert(mem_to_offset(huge) == MEM_INVALID_OFFSET); // Not carved from the pool
+    memset(huge, 'h', 8192);
+
+    void *block = mem_alloc(1024); // The whole pool is still available
+    my_assert(block != NULL);
+
+    huge = mem_resize(huge, 1024 * 1024); // Grown by remapping, contents kept
+    my_assert(huge != NULL);
+    my_assert(huge[0] == 'h' && huge[8191] == 'h');
+
+    mem_free(block);
+    huge = mem_resize(huge, 100); // Small again, so it moves into the pool
+    my_assert(huge != NULL && mem_to_offset(huge) == 0);
+    my_assert(huge[0] == 'h' && huge[99] == 'h');
+    mem_free(huge);
+
+    // The registry stays ordered as blocks come, go and move
+    char *many[8];
+    for (int i = 0; i < 8; i++)
+    {
+        many[i] = mem_alloc(8192 * (i + 1));
+        my_assert(many[i] != NULL);
+    }
+    mem_free(many[3]);
+    many[5] = mem_resize(many[5], 1024 * 1024);
+    for (int i = 0; i < 8; i++)
+    {
+        if (i == 3)
+        {
+            continue;
+        }
+        void *start;
+        size_t size;
+        my_assert(mem_find_block(many[i] + 4000, &start, &size) && start == many[i]);
+        my_assert(size == (i == 5 ? 1024 * 1024 : 8192 * (size_t)(i + 1)));
+        mem_free(many[i]);
+    }
+
+    mem_set_mmap_threshold(0);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_resize_by_remap()
+{
+    printf_yellow("  Testing large resize moving pages instead of bytes ---> ");
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    mem_init(4 * 1024 * 1024);
+
+    size_t size = 64 * page + 100; // Whole pages plus a tail that has to be copied
+    unsigned char *block = mem_alloc(size);
+    void *neighbour = mem_alloc(16); // Blocks growing in place
+    my_assert(block != NULL && neighbour != NULL);
+    for (size_t i = 0; i < size; i++)
+    {
+        block[i] = (unsigned char)(i * 7);
+    }
+
+    unsigned char *moved = mem_resize(block, 2 * size);
+    my_assert(moved != NULL && moved != block);
+    my_assert(((size_t)moved & (page - 1)) == 0);
+    for (size_t i = 0; i < size; i++)
+    {
+        my_assert(moved[i] == (unsigned char)(i * 7));
+    }
+
+    // The old range is usable pool memory again
+    unsigned char *reuse = mem_alloc(size);
+    my_assert(reuse == block);
+    memset(reuse, 0xab, size);
+
+    mem_free(reuse);
+    mem_free(moved);
+    mem_free(neighbour);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_resize_backwards()
+{
+    printf_yellow("  Testing mem_resize growing into preceding free space ---> ");
+    mem_init(1024);
+
+    char *block1 = mem_alloc(100);
+    char *block2 = mem_alloc(100);
+    char *block3 = mem_alloc(100);
+    char *block4 = mem_alloc(100);
+    memset(block2, 'b', 100);
+
+    // Only the space before block2 is free; it slides back just as far as needed
+    mem_free(block1);
+    char *grown = mem_resize(block2, 180);
+    my_assert(grown == block2 - 80);
+    my_assert(grown[0] == 'b' && grown[99] == 'b');
+
+    // Free space on both sides together
+    mem_free(block3);
+    grown = mem_resize(grown, 300);
+    my_assert(grown == block1);
+    my_assert(grown[0] == 'b' && grown[99] == 'b');
+    my_assert(mem_alloc(1) == block4 + 100); // No gap was left before block4
+
+    mem_free(block4);
+    mem_free(grown);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_growth_policy()
+{
+    printf_yellow("  Testing geometric growth for repeated mem_resize ---> ");
+    mem_init(4096);
+    mem_set_growth_policy(true);
+
+    char *buffer = mem_alloc(100);
+    void *neighbour = mem_alloc(10); // Stops the buffer from growing in place
+    memset(buffer, 'g', 100);
+
+    // Growing past the neighbour moves once and reserves twice the capacity
+    buffer = mem_resize(buffer, 101);
+    my_assert(buffer != NULL && mem_usable_size(buffer) == 200);
+
+    MemStats stats;
+    mem_get_stats(&stats);
+    my_assert(stats.resizes_moved == 1);
+    my_assert(stats.allocated_bytes == 111 && stats.reserved_bytes == 99);
+
+    // Small increments up to the capacity never move the block again
+    char *start = buffer;
+    for (size_t size = 102; size <= 200; size++)
+    {
+        buffer = mem_resize(buffer, size);
+        my_assert(buffer == start);
+    }
+    my_assert(buffer[0] == 'g' && buffer[99] == 'g');
+    mem_get_stats(&stats);
+    my_assert(stats.resizes_moved == 1 && stats.reserved_bytes == 0);
+
+    // Freeing gives back the block together with its slack
+    buffer = mem_resize(buffer, 150);
+    mem_free(buffer);
+    mem_free(neighbour);
+    mem_get_stats(&stats);
+    my_assert(stats.free_bytes == 4096 && stats.reserved_bytes == 0);
+
+    mem_set_growth_policy(false);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_resize_hint()
+{
+    printf_yellow("  Testing mem_resize_hint ---> ");
+    mem_init(1024);
+
+    char *buffer = mem_alloc(50);
+    void *neighbour = mem_alloc(10);
+    memset(buffer, 'h', 50);
+
+    buffer = mem_resize_hint(buffer, 500); // Moves past the neighbour once, keeps its size
+    my_assert(buffer != NULL && mem_usable_size(buffer) == 500);
+    my_assert(buffer[0] == 'h' && buffer[49] == 'h');
+
+    char *start = buffer;
+    buffer = mem_resize(buffer, 300);
+    my_assert(buffer == start);
+    buffer = mem_resize(buffer, 500);
+    my_assert(buffer == start);
+
+    MemStats stats;
+    mem_get_stats(&stats);
+    my_assert(stats.allocated_bytes == 510 && stats.reserved_bytes == 0);
+
+    mem_free(buffer);
+    mem_free(neighbour);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// Records the extents seen by mem_walk
+typedef struct
+{
+    MemExtent extents[16];
+    int count;
+} WalkLog;
+
+int record_extent(const MemExtent *extent, void *ctx)
+{
+    WalkLog *log = ctx;
+    log->extents[log->count++] = *extent;
+    return log->count == 16;
+}
+
+void test_mem_walk()
+{
+    printf_yellow("  Testing mem_walk ---> ");
+    mem_init(1024);
+    mem_set_mmap_threshold(4096);
+
+    void *block1 = mem_alloc(100);
+    void *block2 = mem_alloc(200);
+    void *huge = mem_alloc(8192);
+    mem_free(block1);
+    block2 = mem_resize_hint(block2, 300); // 100 bytes of slack after block2
+
+    WalkLog log = {0};
+    my_assert(mem_walk(record_extent, &log) == 0);
+    my_assert(log.count == 5);
+    my_assert(log.extents[0].state == MEM_EXTENT_FREE && log.extents[0].offset == 0 && log.extents[0].size == 100);
+    my_assert(log.extents[1].state == MEM_EXTENT_ALLOCATED && log.extents[1].address == block2 && log.extents[1].size == 200);
+    my_assert(log.extents[2].state == MEM_EXTENT_RESERVED && log.extents[2].offset == 300 && log.extents[2].size == 100);
+    my_assert(log.extents[3].state == MEM_EXTENT_FREE && log.extents[3].offset == 400 && log.extents[3].size == 624);
+    my_assert(log.extents[4].tag == MEM_TAG_HUGE && log.extents[4].address == huge && log.extents[4].size == 8192);
+
+    mem_free(block2);
+    mem_free(huge);
+    mem_set_mmap_threshold(0);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_find_block()
+{
+    printf_yellow("  Testing mem_find_block with interior pointers ---> ");
+    const int nBlocks = 2000;
+    mem_init(nBlocks * 64);
+
+    // Blocks of varying size with every third one freed again
+    char *blocks[nBlocks];
+    size_t sizes[nBlocks];
+    for (int k = 0; k < nBlocks; k++)
+    {
+        sizes[k] = 1 + (k * 37) % 60;
+        blocks[k] = mem_alloc(sizes[k]);
+        my_assert(blocks[k] != NULL);
+    }
+    for (int k = 0; k < nBlocks; k += 3)
+    {
+        mem_free(blocks[k]);
+    }
+
+    for (int k = 0; k < nBlocks; k++)
+    {
+        void *start = NULL;
+        size_t size = 0;
+        bool found = mem_find_block(blocks[k] + sizes[k] / 2, &start, &size);
+        if (k % 3 == 0)
+        {
+            my_assert(!found);
+        }
+        else
+        {
+            my_assert(found && start == blocks[k] && size == sizes[k]);
+        }
+    }
+
+    // The byte just past a live block belongs to its neighbour or to nobody
+    void *start = NULL;
+    my_assert(!mem_find_block(blocks[nBlocks - 1] + sizes[nBlocks - 1], &start, NULL));
+    my_assert(!mem_find_block(&start, NULL, NULL)); // Not in the pool at all
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// ********* Reclamation *********
+
+typedef struct GcLink
+{
+    struct GcLink *next;
+    size_t value;
+} GcLink;
+
+void test_gc_incremental()
+{
+    printf_yellow("  Testing incremental mark-sweep reclamation ---> ");
+    mem_init(1024);
+
+    // a -> b -> c is reachable; d points into the chain but nothing points to d; e is plainly lost
+    GcLink *a = mem_alloc(sizeof(GcLink));
+    GcLink *b = mem_alloc(sizeof(GcLink));
+    GcLink *c = mem_alloc(sizeof(GcLink));
+    GcLink *d = mem_alloc(sizeof(GcLink));
+    GcLink *e = mem_alloc(sizeof(GcLink));
+    a->next = b;
+    b->next = c;
+    c->next = NULL;
+    d->next = c;
+    e->next = NULL;
+
+    void *roots[] = {a};
+    my_assert(mem_gc_begin(roots, 1));
+    my_assert(!mem_gc_begin(roots, 1)); // One cycle at a time
+
+    // Two words scan a completely, then unlink b the way list_delete does
+    my_assert(!mem_gc_step(2));
+    a->next = c;
+    mem_free(b);
+
+    // A block allocated mid-cycle survives it, and so does what it points to
+    GcLink *f = mem_alloc(sizeof(GcLink));
+    f->next = NULL;
+    c->next = f;
+
+    int steps = 0;
+    while (!mem_gc_step(1))
+    {
+        steps++;
+    }
+    my_assert(steps > 1);
+
+    my_assert(mem_find_block(a, NULL, NULL));
+    my_assert(mem_find_block(c, NULL, NULL));
+    my_assert(mem_find_block(f, NULL, NULL));
+    my_assert(!mem_find_block(d, NULL, NULL));
+    my_assert(!mem_find_block(e, NULL, NULL));
+
+    MemStats stats;
+    mem_get_stats(&stats);
+    my_assert(stats.allocated_bytes == 3 * sizeof(GcLink));
+
+    // Nothing new is unreachable, and interior pointers count as references
+    void *interior[] = {&a->value};
+    my_assert(mem_gc_collect(interior, 1) == 0);
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+static _Atomic bool stats_churn_stop;
+
+static void *churn_stats(void *arg)
+{
+    (void)arg;
+    while (!stats_churn_stop)
+    {
+        mem_free(mem_alloc(16));
+    }
+    return NULL;
+}
+
+void test_stats_page()
+{
+    printf_yellow("  Testing the live statistics page ---> ");
+    const char *name = "/test_memory_manager_stats";
+    mem_init(1024);
+    my_assert(mem_stats_publish(name) == 0);
+
+    // Attach the way mmstat does
+    int fd = shm_open(name, O_RDONLY, 0);
+    my_assert(fd != -1);
+    const MemStatsPage *page = mmap(NULL, sizeof(MemStatsPage), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    my_assert(page != MAP_FAILED);
+    my_assert(page->magic == MEM_STATS_MAGIC && page->pid == (uint64_t)getpid());
+    my_assert(page->pool_size == 1024 && page->free_bytes == 1024);
+
+    void *blocks[4];
+    for (int i = 0; i < 4; i++)
+    {
+        blocks[i] = mem_alloc(100);
+    }
+    blocks[0] = mem_resize(blocks[0], 150);
+    my_assert(mem_alloc(2000) == NULL);
+    for (int i = 0; i < 4; i++)
+    {
+        mem_free(blocks[i]);
+    }
+
+    my_assert(page->ops[MEM_STATS_ALLOC] == 5);
+    my_assert(page->ops[MEM_STATS_RESIZE] == 1);
+    my_assert(page->ops[MEM_STATS_FREE] == 4);
+    my_assert(page->failures == 1);
+    uint64_t timed = 0;
+    for (int i = 0; i < MEM_STATS_BUCKETS; i++)
+    {
+        timed += page->latency[i];
+    }
+    my_assert(timed == 10);
+
+    // Usage follows every operation; a pool this small is covered by one pass
+    void *block = mem_alloc(24);
+    my_assert(page->allocated_bytes == 24 && page->free_bytes == 1000);
+    my_assert(page->largest_free_block == 1000);
+    mem_free(block);
+    my_assert(page->allocated_bytes == 0 && page->largest_free_block == 1024);
+
+    // The other allocation entry points are counted too; a page does not fit this pool
+    void *counted = mem_alloc_rc(8);
+    counted = mem_resize_hint(counted, 64);
+    mem_release(counted);
+    my_assert(mem_alloc_pages(1) == NULL);
+    my_assert(page->ops[MEM_STATS_ALLOC] == 8);
+    my_assert(page->ops[MEM_STATS_RESIZE] == 2);
+    my_assert(page->ops[MEM_STATS_FREE] == 6);
+    my_assert(page->failures == 2);
+
+    munmap((void *)page, sizeof(MemStatsPage));
+    mem_stats_unpublish();
+    my_assert(shm_open(name, O_RDONLY, 0) == -1);
+
+    // Unpublishing waits for threads still writing to the page
+    mem_set_thread_safe(true);
+    stats_churn_stop = false;
+    pthread_t churner;
+    my_assert(pthread_create(&churner, NULL, churn_stats, NULL) == 0);
+    for (int round = 0; round < 200; round++)
+    {
+        my_assert(mem_stats_publish(name) == 0);
+        sched_yield();
+        mem_stats_unpublish();
+    }
+    stats_churn_stop = true;
+    pthread_join(churner, NULL);
+    mem_set_thread_safe(false);
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_compact_metadata()
+{
+    printf_yellow("  Testing 32-bit block sizes for pools under 4 GiB ---> ");
+    size_t size = 1 << 20;
+    mem_init(size);
+
+    // One map byte plus a 4-byte size entry per pool byte, and a little for the header and index
+    MemStats stats;
+    mem_get_stats(&stats);
+    my_assert(stats.metadata_bytes > size * 5);
+    my_assert(stats.metadata_bytes < size * 11 / 2);
+
+    // Sizes well past 16 bits survive the narrower entries
+    char *big = mem_alloc(size - 4096);
+    my_assert(big != NULL);
+    my_assert(mem_usable_size(big) == size - 4096);
+    void *start = NULL;
+    size_t found = 0;
+    my_assert(mem_find_block(big + 300000, &start, &found));
+    my_assert(start == big && found == size - 4096);
+
+    my_assert(mem_resize(big, size) == big);
+    my_assert(mem_usable_size(big) == size);
+    mem_free(big);
+
+    mem_get_stats(&stats);
+    my_assert(stats.allocated_bytes == 0 && stats.largest_free_block == size);
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_alloc_aligned()
+{
+    printf_yellow("  Testing aligned blocks ---> ");
+    mem_init(1024);
+
+    // Aligned blocks skip misaligned free bytes, which stay usable for plain blocks
+    char *small = mem_alloc(10);
+    char *line = mem_alloc_aligned(64, 64);
+    my_assert(line != NULL && ((uintptr_t)line & 63) == 0);
+    my_assert(line == small + 64);
+    my_assert(mem_alloc(54) == small + 10);
+    char *wide = mem_alloc_aligned(100, 256);
+    my_assert(wide != NULL && ((uintptr_t)wide & 255) == 0);
+
+    my_assert(mem_alloc_aligned(64, 48) == NULL);
+    my_assert(mem_alloc_aligned(64, 0) == NULL);
+    my_assert(mem_alloc_aligned(1024, 64) == NULL);
+
+    mem_free(wide);
+    mem_free(line);
+    mem_free(small + 10);
+    mem_free(small);
+    MemStats stats;
+    mem_get_stats(&stats);
+    my_assert(stats.allocated_bytes == 0);
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_alloc_pages()
+{
+    printf_yellow("  Testing page-aligned buffers from the page region ---> ");
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    mem_init(page * 16);
+    char *base = mem_from_offset(0);
+
+    // Page buffers come from the end of the pool, byte blocks from the start
+    char *p1 = mem_alloc_pages(2);
+    my_assert(p1 == base + page * 14);
+    my_assert(((size_t)p1 % page) == 0);
+    char *small = mem_alloc(100);
+    my_assert(small == base);
+    char *p2 = mem_alloc_pages(3);
+    my_assert(p2 == base + page * 11);
+
+    // Freed pages inside the region go to the next page buffer, not to byte blocks
+    mem_free(p1);
+    my_assert(mem_alloc(page * 12) == NULL);
+    char *p3 = mem_alloc_pages(2);
+    my_assert(p3 == p1);
+
+    // Freeing the lowest pages gives them back to the byte-granular space
+    mem_free(p2);
+    char *big = mem_alloc(page * 14 - 100);
+    my_assert(big == small + 100);
+
+    my_assert(mem_resize(p3, 10) == NULL);
+    my_assert(mem_alloc_pages(1) == NULL);
+
+    // Page counts whose byte size wraps around must not pass as small requests
+    my_assert(mem_alloc_pages(SIZE_MAX / page + 1) == NULL);
+    my_assert(mem_alloc_pages(SIZE_MAX / page) == NULL);
+
+    mem_free(big);
+    mem_free(p3);
+    mem_free(small);
+    MemStats stats;
+    mem_get_stats(&stats);
+    my_assert(stats.largest_free_block == page * 16);
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// ********* Ring mode *********
+
+void test_ring_mode()
+{
+    printf_yellow("  Testing ring allocation with in-order and out-of-order frees ---> ");
+    mem_init(1000);
+    mem_set_ring_mode(true);
+
+    char *a = mem_alloc(400);
+    char *b = mem_alloc(400);
+    my_assert(b == a + 400);
+    my_assert(mem_alloc(300) == NULL); // 200 bytes left before the end, and the oldest block is live
+
+    // Freeing a newer block first does not hand its bytes back yet
+    mem_free(b);
+    char *d = mem_alloc(150);
+    my_assert(d == a + 800);
+
+    // Freeing the oldest block moves the tail past it and the freed block after it, to d
+    mem_free(a);
+    char *e = mem_alloc(500);
+    my_assert(e == a); // Wrapped to the start
+    char *f = mem_alloc(300);
+    my_assert(f == a + 500);
+    my_assert(mem_alloc(1) == NULL); // The head has caught up with the tail
+
+    mem_free(d);
+    mem_free(e);
+    mem_free(f);
+
+    // An empty ring starts over at the front, so the whole pool is one run again
+    char *g = mem_alloc(100);
+    my_assert(g == a);
+    my_assert(mem_resize(g, 1000) == g); // The newest block grows by pushing the head
+
+    mem_set_ring_mode(false); // Refused while blocks are live
+    my_assert(mem_alloc(1) == NULL);
+    mem_free(g);
+
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+// ********* Threads *********
+
+#define RC_THREADS 4
+#define RC_ROUNDS 10000
+
+static void *share_rc_block(void *block)
+{
+    for (int i = 0; i < RC_ROUNDS; i++)
+    {
+        mem_retain(block);
+        mem_release(block);
+    }
+    mem_release(block); // Drop the reference the main thread handed over
+    return NULL;
+}
+
+void test_refcount()
+{
+    printf_yellow("  Testing reference-counted blocks shared between threads ---> ");
+    mem_init(1024);
+    mem_set_thread_safe(true);
+
+    char *block = mem_alloc_rc(64);
+    my_assert(block != NULL);
+    my_assert(mem_ref_count(block) == 1);
+    my_assert(((size_t)block % sizeof(size_t)) == 0);
+
+    pthread_t threads[RC_THREADS];
+    for (int t = 0; t < RC_THREADS; t++)
+    {
+        mem_retain(block);
+        my_assert(pthread_create(&threads[t], NULL, share_rc_block, block) == 0);
+    }
+    for (int t = 0; t < RC_THREADS; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+
+    my_assert(mem_ref_count(block) == 1);
+    MemStats stats;
+    mem_get_stats(&stats);
+    my_assert(stats.allocated_bytes > 64); // The count lives in the same block
+
+    my_assert(mem_release(block) == 0);
+    mem_get_stats(&stats);
+    my_assert(stats.allocated_bytes == 0);
+
+    mem_set_thread_safe(false);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+static void *churn_deferred(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < 1000; i++)
+    {
+        char *block = mem_alloc(16 + i % 64);
+        my_assert(block != NULL);
+        block[0] = (char)i;
+        mem_free(block);
+    }
+    return NULL;
+}
+
+void test_gc_deferred_free()
+{
+    printf_yellow("  Testing a collection while frees are still queued ---> ");
+    enum { BLOCKS = 64 };
+    mem_init(BLOCKS * 64);
+    mem_set_thread_safe(true);
+    mem_set_deferred_free(true, false);
+
+    for (int round = 0; round < 50; round++)
+    {
+        void *old_blocks[BLOCKS];
+        for (int i = 0; i < BLOCKS; i++)
+        {
+            old_blocks[i] = mem_alloc(32);
+            my_assert(old_blocks[i] != NULL);
+        }
+        for (int i = 0; i < BLOCKS; i++)
+        {
+            mem_free(old_blocks[i]); // Queued, and unreachable for the collector
+        }
+        mem_gc_collect(NULL, 0);
+
+        // New blocks take the same bytes; the background thread must not free them afterwards
+        void *new_blocks[BLOCKS];
+        for (int i = 0; i < BLOCKS; i++)
+        {
+            new_blocks[i] = mem_alloc(32);
+            my_assert(new_blocks[i] != NULL);
+        }
+        mem_flush_deferred();
+        for (int i = 0; i < BLOCKS; i++)
+        {
+            void *start = NULL;
+            size_t size = 0;
+            my_assert(mem_find_block(new_blocks[i], &start, &size) && start == new_blocks[i]);
+        }
+        for (int i = 0; i < BLOCKS; i++)
+        {
+            mem_free(new_blocks[i]);
+        }
+        mem_flush_deferred();
+    }
+
+    MemStats stats;
+    mem_get_stats(&stats);
+    my_assert(stats.allocated_bytes == 0);
+
+    mem_set_deferred_free(false, false);
+    mem_set_thread_safe(false);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_deferred_free()
+{
+    printf_yellow("  Testing frees deferred to a background thread ---> ");
+    mem_init(4096);
+    mem_set_deferred_free(true, true); // Refused: the pool is not thread safe yet
+    mem_set_thread_safe(true);
+    mem_set_deferred_free(true, true);
+
+    unsigned char *block = mem_alloc(100);
+    memset(block, 0xAB, 100);
+    mem_free(block);
+    mem_flush_deferred();
+
+    MemStats stats;
+    mem_get_stats(&stats);
+    my_assert(stats.allocated_bytes == 0);
+    for (int i = 0; i < 100; i++)
+    {
+        my_assert(block[i] == 0); // Cleared before the bytes became free
+    }
+
+    // A full-pool request right after a free must not fail just because the free is still queued
+    for (int round = 0; round < 100; round++)
+    {
+        void *whole = mem_alloc(4096);
+        my_assert(whole != NULL);
+        mem_free(whole);
+    }
+
+    pthread_t threads[RC_THREADS];
+    for (int t = 0; t < RC_THREADS; t++)
+    {
+        my_assert(pthread_create(&threads[t], NULL, churn_deferred, NULL) == 0);
+    }
+    for (int t = 0; t < RC_THREADS; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+    mem_flush_deferred();
+    mem_get_stats(&stats);
+    my_assert(stats.allocated_bytes == 0);
+
+    // Switching deferred frees off while threads free must not strand a queued block
+    for (int t = 0; t < RC_THREADS; t++)
+    {
+        my_assert(pthread_create(&threads[t], NULL, churn_deferred, NULL) == 0);
+    }
+    for (int round = 0; round < 20; round++)
+    {
+        mem_set_deferred_free(false, false);
+        sched_yield();
+        mem_set_deferred_free(true, true);
+    }
+    for (int t = 0; t < RC_THREADS; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+    mem_flush_deferred();
+    mem_get_stats(&stats);
+    my_assert(stats.allocated_bytes == 0);
+
+    mem_set_deferred_free(false, false);
+    mem_set_thread_safe(false);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_io_fixed_buffers()
+{
+    printf_yellow("  Testing file I/O into pool blocks ---> ");
+    const char *path = "test_mem_io.dat";
+    mem_init(64 * 1024);
+    my_assert(mem_pool_size() == 64 * 1024); // What the ring registers
+    my_assert(mem_io_init(8));
+    int fd = open(path, O_CREAT | O_TRUNC | O_RDWR, 0644);
+    my_assert(fd != -1);
+
+    // Round trip through registered pool memory
+    char *out = mem_alloc(16 * 1024);
+    for (int i = 0; i < 16 * 1024; i++)
+    {
+        out[i] = (char)(i * 7);
+    }
+    my_assert(mem_io_write(fd, out, 16 * 1024, 0) == 16 * 1024);
+
+    // A batch larger than the queue, read back in reverse order
+    MemIoRequest requests[16];
+    char *in[16];
+    for (int i = 0; i < 16; i++)
+    {
+        in[i] = mem_alloc(1024);
+        requests[i] = (MemIoRequest){.fd = fd, .buffer = in[i], .length = 1024, .offset = (15 - i) * 1024};
+    }
+    my_assert(mem_io_submit(requests, 16) == 16);
+    for (int i = 0; i < 16; i++)
+    {
+        my_assert(requests[i].result == 1024);
+        my_assert(memcmp(in[i], out + (15 - i) * 1024, 1024) == 0);
+    }
+
+    // Memory outside the pool, short reads and errors behave like pread
+    char outside[512];
+    my_assert(mem_io_read(fd, outside, sizeof(outside), 1000) == sizeof(outside));
+    my_assert(memcmp(outside, out + 1000, sizeof(outside)) == 0);
+    my_assert(mem_io_read(fd, in[0], 1024, 16 * 1024 - 100) == 100);
+    my_assert(mem_io_read(fd, in[0], 1024, 16 * 1024) == 0);
+    my_assert(mem_io_read(-1, in[0], 1024, 0) == -EBADF);
+
+    // Without the ring the same calls go through pread/pwrite
+    mem_io_deinit();
+    my_assert(!mem_io_uring_active());
+    memset(in[1], 0, 1024);
+    my_assert(mem_io_read(fd, in[1], 1024, 2048) == 1024);
+    my_assert(memcmp(in[1], out + 2048, 1024) == 0);
+
+    close(fd);
+    unlink(path);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
+void test_io_after_remap()
+{
+    printf_yellow("  Testing file I/O into a block moved by remapping ---> ");
+    const char *path = "test_mem_io_remap.dat";
+    mem_init(1024 * 1024);
+    my_assert(mem_io_init(8));
+    int fd = open(path, O_CREAT | O_TRUNC | O_RDWR, 0644);
+    my_assert(fd != -1);
+
+    char data[4096];
+    for (int i = 0; i < (int)sizeof(data); i++)
+    {
+        data[i] = (char)(i * 13 + 1);
+    }
+    my_assert(pwrite(fd, data, sizeof(data), 0) == sizeof(data));
+
+    // The neighbour forces the resize to move the block, which goes by remapping its pages
+    char *block = mem_alloc(64 * 1024);
+    memset(block, 0, 64 * 1024);
+    char *neighbour = mem_alloc(100);
+    char *moved = mem_resize(block, 128 * 1024);
+    my_assert(moved != NULL && moved != block);
+
+    // The I/O must land in the pages the block has now, both where it moved to and where it was
+    my_assert(mem_io_read(fd, moved, sizeof(data), 0) == sizeof(data));
+    my_assert(memcmp(moved, data, sizeof(data)) == 0);
+    char *reused = mem_alloc(4096);
+    my_assert(reused == block);
+    my_assert(mem_io_read(fd, reused, sizeof(data), 0) == sizeof(data));
+    my_assert(memcmp(reused, data, sizeof(data)) == 0);
+    memset(moved, 0x5A, sizeof(data));
+    my_assert(mem_io_write(fd, moved, sizeof(data), 0) == sizeof(data));
+    char check[4096];
+    my_assert(pread(fd, check, sizeof(check), 0) == sizeof(check));
+    my_assert(memcmp(check, moved, sizeof(check)) == 0);
+
+    mem_free(reused);
+    mem_free(neighbour);
+    mem_free(moved);
+    mem_io_deinit();
+    close(fd);
+    unlink(path);
+    mem_deinit();
+    printf_green("[PASS].\n");
+}
+
 int main(int argc, char *argv[])
 {
 #ifdef VERSION
@@ -358,11 +1389,44 @@ int main(int argc, char *argv[])
         printf(" 14. test_block_merging - Test merging of adjacent free blocks\n");
         printf(" 15. test_non_contiguous_allocation_failure - Ensure failure when no contiguous block fits\n");
         printf(" 16. test_contiguous_allocation_success - Ensure success when a contiguous block fits\n");
+        printf(" 36. test_first_fit_hint - Test that first fit skips the allocated prefix and still finds lower holes\n");
 
 	
 	printf("\nVarious tests: \n");
 	printf(" 17. test_zero_alloc_and_free - Ensure that we can allocate 0 bytes, and it does not fail.\n");
-	printf(" 18. test_random_blocks - Test that we can allocate a random size, and random amounts of blocks [1000,10000]. \n\n");
+	printf(" 18. test_random_blocks - Test that we can allocate a random size, and random amounts of blocks [1000,10000]. \n");
+
+        printf("\nProfiling and Introspection:\n");
+        printf(" 19. test_profile_sampling - Test that sampled allocations are attributed to their call sites\n");
+        printf(" 26. test_mem_walk - Test visiting the pool's extents in address order\n");
+        printf(" 27. test_find_block - Test finding the block that contains an address\n");
+        printf(" 31. test_stats_page - Test publishing live statistics in shared memory\n");
+        printf(" 33. test_compact_metadata - Test the 32-bit size map of pools under 4 GiB\n");
+
+        printf("\nShared Pools:\n");
+        printf(" 20. test_shared_pool - Test a pool shared between two processes at different addresses\n");
+
+        printf("\nLarge Blocks:\n");
+        printf(" 21. test_huge_allocation - Test that huge requests are mapped outside the pool\n");
+        printf(" 22. test_resize_by_remap - Test that large blocks move by remapping pages\n");
+        printf(" 23. test_resize_backwards - Test that blocks grow into free space before them\n");
+        printf(" 24. test_growth_policy - Test geometric slack for repeatedly grown blocks\n");
+        printf(" 25. test_resize_hint - Test reserving room for a block's expected size\n");
+        printf(" 34. test_alloc_pages - Test page-aligned buffers kept apart from byte blocks\n");
+        printf(" 35. test_io_fixed_buffers - Test file I/O into blocks through registered buffers\n");
+        printf(" 38. test_io_after_remap - Test file I/O into a block moved by remapping its pages\n");
+        printf(" 39. test_alloc_aligned - Test blocks aligned to a power of two\n");
+
+        printf("\nReclamation:\n");
+        printf(" 28. test_gc_incremental - Test freeing unreachable blocks in bounded steps\n");
+        printf(" 37. test_gc_deferred_free - Test that a collection does not free blocks still queued for freeing\n");
+
+        printf("\nRing Mode:\n");
+        printf(" 30. test_ring_mode - Test FIFO allocation around the pool\n");
+
+        printf("\nThreads:\n");
+        printf(" 29. test_refcount - Test atomically reference-counted blocks\n");
+        printf(" 32. test_deferred_free - Test frees done by a background thread\n\n");
         printf(" 0. Run all tests\n");
         return 1;
     }
@@ -395,10 +1459,43 @@ int main(int argc, char *argv[])
         test_block_merging();
         test_non_contiguous_allocation_failure();
         test_contiguous_allocation_success();
+        test_first_fit_hint();
 
         printf("\nVarious other tests:\n");
         test_zero_alloc_and_free();
         test_random_blocks();
+
+        printf("\nTesting Profiling and Introspection:\n");
+        test_profile_sampling();
+        test_mem_walk();
+        test_find_block();
+        test_stats_page();
+        test_compact_metadata();
+
+        printf("\nTesting Shared Pools:\n");
+        test_shared_pool();
+
+        printf("\nTesting Large Blocks:\n");
+        test_huge_allocation();
+        test_resize_by_remap();
+        test_resize_backwards();
+        test_growth_policy();
+        test_resize_hint();
+        test_alloc_pages();
+        test_io_fixed_buffers();
+        test_io_after_remap();
+        test_alloc_aligned();
+
+        printf("\nTesting Reclamation:\n");
+        test_gc_incremental();
+        test_gc_deferred_free();
+
+        printf("\nTesting Ring Mode:\n");
+        test_ring_mode();
+
+        printf("\nTesting Threads:\n");
+        test_refcount();
+        test_deferred_free();
         break;
     case 1:
         test_init();
@@ -454,6 +1551,69 @@ int main(int argc, char *argv[])
     case 18:
         test_random_blocks();
         break;
+    case 19:
+        test_profile_sampling();
+        break;
+    case 20:
+        test_shared_pool();
+        break;
+    case 21:
+        test_huge_allocation();
+        break;
+    case 22:
+        test_resize_by_remap();
+        break;
+    case 23:
+        test_resize_backwards();
+        break;
+    case 24:
+        test_growth_policy();
+        break;
+    case 25:
+        test_resize_hint();
+        break;
+    case 26:
+        test_mem_walk();
+        break;
+    case 27:
+        test_find_block();
+        break;
+    case 28:
+        test_gc_incremental();
+        break;
+    case 29:
+        test_refcount();
+        break;
+    case 30:
+        test_ring_mode();
+        break;
+    case 31:
+        test_stats_page();
+        break;
+    case 32:
+        test_deferred_free();
+        break;
+    case 33:
+        test_compact_metadata();
+        break;
+    case 34:
+        test_alloc_pages();
+        break;
+    case 35:
+        test_io_fixed_buffers();
+        break;
+    case 36:
+        test_first_fit_hint();
+        break;
+    case 37:
+        test_gc_deferred_free();
+        break;
+    case 38:
+        test_io_after_remap();
+        break;
+    case 39:
+        test_alloc_aligned();
+        break;
     default:
         printf("Invalid test function\n");
         break;
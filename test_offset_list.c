@@ -0,0 +1,216 @@
+#include "offset_list.h"
+#include "memory_manager.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "common_defs.h"
+#include "gitdata.h"
+
+// ********* Test basic offset list operations *********
+
+void test_olist_init()
+{
+    printf_yellow("  Testing olist_init ---> ");
+    OffsetList list = {0, 0, 1};
+    olist_init(&list, sizeof(OffsetNode));
+    my_assert(list.head == OLIST_NULL && list.tail == OLIST_NULL);
+    my_assert(olist_count_nodes(&list) == 0);
+    my_assert(sizeof(OffsetNode) == 8);
+    olist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_olist_insert()
+{
+    printf_yellow("  Testing olist_insert, olist_insert_after and olist_insert_before ---> ");
+    OffsetList list;
+    olist_init(&list, sizeof(OffsetNode) * 4);
+    olist_insert(&list, 10);
+    olist_insert(&list, 40);
+    olist_insert_after(&list, list.head, 20);
+    olist_insert_before(&list, olist_search(&list, 40), 30);
+
+    OffsetNode *node = olist_node(list.head);
+    for (int value = 10; value <= 40; value += 10)
+    {
+        my_assert(node != NULL && node->data == value);
+        node = olist_node(node->next);
+    }
+    my_assert(node == NULL);
+    my_assert(olist_count_nodes(&list) == 4);
+
+    olist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_olist_delete_and_search()
+{
+    printf_yellow("  Testing olist_delete and olist_search ---> ");
+    OffsetList list;
+    olist_init(&list, sizeof(OffsetNode) * 3);
+    olist_insert(&list, 10);
+    olist_insert(&list, 20);
+    olist_insert(&list, 30);
+
+    my_assert(olist_node(olist_search(&list, 20))->data == 20);
+    my_assert(olist_search(&list, 99) == OLIST_NULL);
+
+    olist_delete(&list, 10);
+    my_assert(olist_node(list.head)->data == 20);
+    olist_delete(&list, 30);
+    my_assert(list.tail == list.head);
+    olist_delete(&list, 20);
+    my_assert(list.head == OLIST_NULL && list.tail == OLIST_NULL);
+    my_assert(olist_count_nodes(&list) == 0);
+
+    olist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_olist_display()
+{
+    printf_yellow("  Testing olist_display_range ---> ");
+    OffsetList list;
+    olist_init(&list, sizeof(OffsetNode) * 4);
+    for (int value = 1; value <= 4; value++)
+    {
+        olist_insert(&list, value);
+    }
+
+    char buffer[64] = {0};
+    FILE *original_stdout = stdout;
+    FILE *fp = tmpfile();
+    my_assert(fp != NULL);
+    stdout = fp;
+    olist_display_range(&list, olist_search(&list, 2), olist_search(&list, 3));
+    fflush(fp);
+    stdout = original_stdout;
+    rewind(fp);
+    fread(buffer, 1, sizeof(buffer) - 1, fp);
+    fclose(fp);
+    my_assert(strcmp(buffer, "[2, 3]") == 0);
+
+    olist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_olist_append_large(int count)
+{
+    printf_yellow("  Testing olist_insert appending %d nodes ---> ", count);
+    OffsetList list;
+    olist_init(&list, sizeof(OffsetNode) * count);
+    for (int i = 0; i < count; i++)
+    {
+        olist_insert(&list, (uint16_t)i);
+        my_assert(olist_node(list.tail)->data == (uint16_t)i);
+        my_assert(olist_count_nodes(&list) == (size_t)i + 1);
+    }
+    my_assert(olist_node(list.tail)->next == OLIST_NULL);
+
+    olist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+// ********* Relocation *********
+
+void test_olist_relocation()
+{
+    printf_yellow("  Testing olist survives remapping the pool ---> ");
+    const char *name = "/test_offset_list_pool";
+    mem_unlink_shared(name); // Remove leftovers from an aborted run
+    mem_init_shared(name, sizeof(OffsetNode) * 100);
+
+    OffsetList list = {OLIST_NULL, OLIST_NULL, 0};
+    for (int value = 0; value < 100; value++)
+    {
+        olist_insert(&list, value);
+    }
+    OffsetNode *old_head = olist_node(list.head);
+
+    // Map the pool again while its old address is taken, so every raw pointer would be stale
+    mem_deinit();
+    void *filler = mmap(old_head, 4096, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    my_assert(filler == old_head);
+    mem_init_shared(name, sizeof(OffsetNode) * 100);
+    my_assert(olist_node(list.head) != old_head);
+
+    OffsetNode *node = olist_node(list.head);
+    for (int value = 0; value < 100; value++)
+    {
+        my_assert(node != NULL && node->data == value);
+        node = olist_node(node->next);
+    }
+    my_assert(node == NULL);
+
+    olist_cleanup(&list);
+    munmap(filler, 4096);
+    mem_unlink_shared(name);
+    printf_green("[PASS].\n");
+}
+
+// Main function to run all tests
+int main(int argc, char *argv[])
+{
+#ifdef VERSION
+    printf("Build Version; %s \n", VERSION);
+#endif
+    printf("Git Version; %s/%s \n", git_date, git_sha);
+    if (argc < 2)
+    {
+        printf("Usage: %s <test function>\n", argv[0]);
+        printf("Available test functions:\n");
+        printf("Basic Operations:\n");
+        printf(" 1. test_olist_init - Initialize the offset list\n");
+        printf(" 2. test_olist_insert - Test the insert operations\n");
+        printf(" 3. test_olist_delete_and_search - Test delete and search\n");
+        printf(" 4. test_olist_display - Test displaying a range of nodes\n");
+        printf(" 6. test_olist_append_large - Test appending 10000 nodes through the tail reference\n");
+
+        printf("\nRelocation:\n");
+        printf(" 5. test_olist_relocation - Test that the list stays valid when the pool moves\n");
+        printf(" 0. Run all tests\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case -1:
+        printf("No tests will be executed.\n");
+        break;
+    case 0:
+        printf("Testing Basic Operations:\n");
+        test_olist_init();
+        test_olist_insert();
+        test_olist_delete_and_search();
+        test_olist_display();
+        test_olist_append_large(10000);
+
+        printf("\nTesting Relocation:\n");
+        test_olist_relocation();
+        break;
+    case 1:
+        test_olist_init();
+        break;
+    case 2:
+        test_olist_insert();
+        break;
+    case 3:
+        test_olist_delete_and_search();
+        break;
+    case 4:
+        test_olist_display();
+        break;
+    case 5:
+        test_olist_relocation();
+        break;
+    case 6:
+        test_olist_append_large(10000);
+        break;
+    default:
+        printf("Invalid test function\n");
+        break;
+    }
+
+    return 0;
+}
@@ -0,0 +1,356 @@
+#include "unrolled_list.h"
+#include "memory_manager.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "common_defs.h"
+#include "gitdata.h"
+
+#define MODEL_MAX 2000
+
+/**
+ * @brief Checks the list against the values it should hold, in order, and its structural invariants.
+ */
+static void check_list(UList *list, const uint16_t *expected, size_t count)
+{
+    size_t seen = 0;
+    UNode *last = NULL;
+    for (UNode *node = list->head; node != NULL; node = node->next)
+    {
+        my_assert(node->count > 0 && node->count <= ULIST_CAPACITY); // No empty nodes are kept
+        for (uint16_t i = 0; i < node->count; i++)
+        {
+            my_assert(seen < count && node->values[i] == expected[seen]);
+            seen++;
+        }
+        last = node;
+    }
+    my_assert(seen == count);
+    my_assert(list->tail == last);
+    my_assert(ulist_count_values(list) == count);
+}
+
+static size_t count_nodes(UList *list)
+{
+    size_t nodes = 0;
+    for (UNode *node = list->head; node != NULL; node = node->next)
+    {
+        nodes++;
+    }
+    return nodes;
+}
+
+/**
+ * @brief Captures what ulist_display_range prints.
+ */
+static void capture_range(UList *list, UListPos start, UListPos end, char *buffer, size_t size)
+{
+    memset(buffer, 0, size);
+    FILE *original_stdout = stdout;
+    FILE *fp = tmpfile();
+    my_assert(fp != NULL);
+    stdout = fp;
+    ulist_display_range(list, start, end);
+    fflush(fp);
+    stdout = original_stdout;
+    rewind(fp);
+    fread(buffer, 1, size - 1, fp);
+    fclose(fp);
+}
+
+static uint32_t rng_state = 12345;
+
+static uint32_t next_random()
+{
+    rng_state = rng_state * 1103515245u + 12345u;
+    return rng_state >> 8;
+}
+
+// ********* Test basic unrolled list operations *********
+
+void test_ulist_init()
+{
+    printf_yellow("  Testing ulist_init ---> ");
+    UList list;
+    ulist_init(&list, sizeof(UNode));
+    my_assert(list.head == NULL && list.tail == NULL && list.count == 0);
+    my_assert(sizeof(UNode) == 64); // One cache line
+    ulist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_ulist_insert()
+{
+    printf_yellow("  Testing ulist_insert packs appended values ---> ");
+    uint16_t expected[100];
+    UList list;
+    ulist_init(&list, sizeof(UNode) * 4);
+    for (int i = 0; i < 100; i++)
+    {
+        expected[i] = (uint16_t)(i * 3);
+        ulist_insert(&list, expected[i]);
+    }
+    check_list(&list, expected, 100);
+    my_assert(count_nodes(&list) == (100 + ULIST_CAPACITY - 1) / ULIST_CAPACITY);
+    for (UNode *node = list.head; node != NULL; node = node->next)
+    {
+        my_assert(((uintptr_t)node & 63) == 0); // Each node in a cache line of its own
+    }
+
+    UListPos pos = ulist_search(&list, 297);
+    my_assert(pos.node == list.tail && ulist_value(pos) == 297);
+    my_assert(ulist_search(&list, 1).node == NULL);
+
+    ulist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_ulist_insert_split()
+{
+    printf_yellow("  Testing ulist_insert_after and ulist_insert_before splitting nodes ---> ");
+    static uint16_t expected[MODEL_MAX];
+    size_t count = 0;
+    UList list;
+    ulist_init(&list, sizeof(UNode) * MODEL_MAX);
+    ulist_insert(&list, 0);
+    expected[count++] = 0;
+
+    // Random inserts next to random existing values, checked against an array
+    for (uint16_t value = 1; count < MODEL_MAX; value++)
+    {
+        size_t at = next_random() % count;
+        UListPos pos = ulist_search(&list, expected[at]);
+        my_assert(pos.node != NULL);
+        size_t dest = at;
+        if (value % 2 == 0)
+        {
+            ulist_insert_after(&list, pos, value);
+            dest = at + 1;
+        }
+        else
+        {
+            ulist_insert_before(&list, pos, value);
+        }
+        memmove(expected + dest + 1, expected + dest, (count - dest) * sizeof(uint16_t));
+        expected[dest] = value;
+        count++;
+
+        if (count % 97 == 0)
+        {
+            check_list(&list, expected, count);
+        }
+    }
+    check_list(&list, expected, count);
+
+    // Splits leave every node at least half full
+    my_assert(count_nodes(&list) <= count / (ULIST_CAPACITY / 2) + 1);
+
+    ulist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_ulist_delete_merge()
+{
+    printf_yellow("  Testing ulist_delete merging sparse nodes ---> ");
+    static uint16_t expected[MODEL_MAX];
+    size_t count = 0;
+    UList list;
+    ulist_init(&list, sizeof(UNode) * MODEL_MAX);
+    for (int i = 0; i < MODEL_MAX; i++)
+    {
+        expected[count++] = (uint16_t)i;
+        ulist_insert(&list, (uint16_t)i);
+    }
+
+    // Delete three quarters of the values in random order
+    while (count > MODEL_MAX / 4)
+    {
+        size_t at = next_random() % count;
+        ulist_delete(&list, expected[at]);
+        memmove(expected + at, expected + at + 1, (count - at - 1) * sizeof(uint16_t));
+        count--;
+        if (count % 89 == 0)
+        {
+            check_list(&list, expected, count);
+        }
+    }
+    check_list(&list, expected, count);
+
+    // Merging keeps the node count close to what the values need
+    my_assert(count_nodes(&list) <= 2 * (count / ULIST_CAPACITY + 1));
+
+    // Delete the rest, head first
+    while (count > 0)
+    {
+        ulist_delete(&list, expected[0]);
+        memmove(expected, expected + 1, (count - 1) * sizeof(uint16_t));
+        count--;
+    }
+    my_assert(list.head == NULL && list.tail == NULL);
+
+    ulist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+void test_ulist_display()
+{
+    printf_yellow("  Testing ulist_display_range across nodes ---> ");
+    UList list;
+    ulist_init(&list, sizeof(UNode) * 2);
+    for (int i = 0; i < 30; i++)
+    {
+        ulist_insert(&list, (uint16_t)i);
+    }
+
+    char buffer[256];
+    UListPos none = {NULL, 0};
+    capture_range(&list, ulist_search(&list, 25), ulist_search(&list, 28), buffer, sizeof(buffer));
+    my_assert(strcmp(buffer, "[25, 26, 27, 28]") == 0);
+    capture_range(&list, ulist_search(&list, 27), none, buffer, sizeof(buffer));
+    my_assert(strcmp(buffer, "[27, 28, 29]") == 0);
+    capture_range(&list, none, ulist_search(&list, 2), buffer, sizeof(buffer));
+    my_assert(strcmp(buffer, "[0, 1, 2]") == 0);
+
+    ulist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+// ********* Search kernels *********
+
+void test_ulist_kernels()
+{
+    printf_yellow("  Testing ulist_search and ulist_count_value with every kernel ---> ");
+    static uint16_t expected[MODEL_MAX];
+    UList list;
+    ulist_init(&list, sizeof(UNode) * MODEL_MAX);
+
+    // Few distinct values, so every value repeats across nodes
+    for (int i = 0; i < MODEL_MAX; i++)
+    {
+        expected[i] = (uint16_t)(next_random() % 50);
+        ulist_insert(&list, expected[i]);
+    }
+
+    // Deleting leaves stale copies past each node's count, which must not be counted
+    for (int i = 0; i < 300; i++)
+    {
+        uint16_t value = expected[i * 5];
+        ulist_delete(&list, value);
+        for (int j = 0; j < MODEL_MAX; j++)
+        {
+            if (expected[j] == value)
+            {
+                expected[j] = UINT16_MAX; // Marks a deleted slot
+                break;
+            }
+        }
+    }
+
+    UListKernel kernels[] = {ULIST_KERNEL_SCALAR, ULIST_KERNEL_SSE2, ULIST_KERNEL_AVX2};
+    for (int k = 0; k < 3; k++)
+    {
+        UListKernel used = ulist_set_kernel(kernels[k]);
+        my_assert(used >= ULIST_KERNEL_SCALAR && used <= kernels[k]);
+        for (uint16_t value = 0; value < 52; value++)
+        {
+            size_t count = 0;
+            for (int j = 0; j < MODEL_MAX; j++)
+            {
+                if (expected[j] == value)
+                {
+                    count++;
+                }
+            }
+            my_assert(ulist_count_value(&list, value) == count);
+
+            // The search finds the first copy: nothing equal comes before it
+            UListPos pos = ulist_search(&list, value);
+            my_assert((pos.node != NULL) == (count > 0));
+            if (pos.node != NULL)
+            {
+                my_assert(ulist_value(pos) == value);
+                for (UNode *node = list.head; node != pos.node; node = node->next)
+                {
+                    for (uint16_t i = 0; i < node->count; i++)
+                    {
+                        my_assert(node->values[i] != value);
+                    }
+                }
+                for (uint16_t i = 0; i < pos.index; i++)
+                {
+                    my_assert(pos.node->values[i] != value);
+                }
+            }
+        }
+    }
+    ulist_set_kernel(ULIST_KERNEL_AUTO);
+
+    ulist_cleanup(&list);
+    printf_green("[PASS].\n");
+}
+
+// Main function to run all tests
+int main(int argc, char *argv[])
+{
+#ifdef VERSION
+    printf("Build Version; %s \n", VERSION);
+#endif
+    printf("Git Version; %s/%s \n", git_date, git_sha);
+    if (argc < 2)
+    {
+        printf("Usage: %s <test function>\n", argv[0]);
+        printf("Available test functions:\n");
+        printf("Basic Operations:\n");
+        printf(" 1. test_ulist_init - Initialize the unrolled list\n");
+        printf(" 2. test_ulist_insert - Test appending values\n");
+        printf(" 3. test_ulist_insert_split - Test inserting next to values, splitting full nodes\n");
+        printf(" 4. test_ulist_delete_merge - Test deleting values, merging sparse nodes\n");
+        printf(" 5. test_ulist_display - Test displaying a range of values\n");
+
+        printf("\nSearch Kernels:\n");
+        printf(" 6. test_ulist_kernels - Test that every search kernel gives the scalar results\n");
+        printf(" 0. Run all tests\n");
+        return 1;
+    }
+
+    switch (atoi(argv[1]))
+    {
+    case -1:
+        printf("No tests will be executed.\n");
+        break;
+    case 0:
+        printf("Testing Basic Operations:\n");
+        test_ulist_init();
+        test_ulist_insert();
+        test_ulist_insert_split();
+        test_ulist_delete_merge();
+        test_ulist_display();
+
+        printf("\nTesting Search Kernels:\n");
+        test_ulist_kernels();
+        break;
+    case 1:
+        test_ulist_init();
+        break;
+    case 2:
+        test_ulist_insert();
+        break;
+    case 3:
+        test_ulist_insert_split();
+        break;
+    case 4:
+        test_ulist_delete_merge();
+        break;
+    case 5:
+        test_ulist_display();
+        break;
+    case 6:
+        test_ulist_kernels();
+        break;
+    default:
+        printf("Invalid test function\n");
+        break;
+    }
+
+    return 0;
+}
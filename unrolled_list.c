@@ -0,0 +1,520 @@
+#include "unrolled_list.h"
+#include "linked_list.h"
+#include "memory_manager.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ULIST_X86 1
+#endif
+
+#define SPLIT_AT (ULIST_CAPACITY / 2)   // Values kept in a full node when it splits
+#define MERGE_BELOW (ULIST_CAPACITY / 2) // Nodes this sparse after a delete merge with a neighbour
+
+// The vector kernels load the whole node as 64 bytes of uint16 lanes, values first
+_Static_assert(offsetof(UNode, values) == 0 && sizeof(UNode) == 64, "UNode must be one 64-byte line");
+
+// Compares a node's values with a value: two bits per slot, set where they are equal
+typedef uint64_t (*match_fn)(const UNode* node, uint16_t data);
+
+// Global Variables
+static match_fn match = NULL; // Kernel in use, chosen on first use
+
+/**
+ * @brief Mask of the bit pairs belonging to the first count slots.
+ */
+static uint64_t slot_mask(uint16_t count) {
+    return count >= 32 ? ~0ULL : (1ULL << (2 * count)) - 1;
+}
+
+static uint64_t match_scalar(const UNode* node, uint16_t data) {
+    uint64_t mask = 0;
+    for (uint16_t i = 0; i < node->count; i++) {
+        if (node->values[i] == data) {
+            mask |= 3ULL << (2 * i);
+        }
+    }
+    return mask;
+}
+
+#ifdef ULIST_X86
+
+// The loads also cover count and next; slot_mask drops those lanes
+
+__attribute__((target("sse2")))
+static uint64_t match_sse2(const UNode* node, uint16_t data) {
+    const __m128i* lines = (const __m128i*)node;
+    __m128i key = _mm_set1_epi16((short)data);
+    uint64_t mask = 0;
+    for (int i = 0; i < 4; i++) {
+        uint16_t bits = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_loadu_si128(lines + i), key));
+        mask |= (uint64_t)bits << (16 * i);
+    }
+    return mask & slot_mask(node->count);
+}
+
+__attribute__((target("avx2")))
+static uint64_t match_avx2(const UNode* node, uint16_t data) {
+    const __m256i* lines = (const __m256i*)node;
+    __m256i key = _mm256_set1_epi16((short)data);
+    uint64_t low = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi16(_mm256_loadu_si256(lines), key));
+    uint64_t high = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi16(_mm256_loadu_si256(lines + 1), key));
+    return (low | high << 32) & slot_mask(node->count);
+}
+
+#endif
+
+/**
+ * @brief The fastest kernel this CPU runs.
+ */
+static UListKernel best_kernel() {
+#ifdef ULIST_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return ULIST_KERNEL_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return ULIST_KERNEL_SSE2;
+    }
+#endif
+    return ULIST_KERNEL_SCALAR;
+}
+
+/**
+ * @brief Chooses the kernel used by ulist_search and ulist_count_value.
+ *
+ * The default is ULIST_KERNEL_AUTO. A kernel the CPU lacks is replaced by the fastest one it has.
+ *
+ * @param kernel Kernel to use.
+ * @return The kernel now in use.
+ */
+UListKernel ulist_set_kernel(UListKernel kernel) {
+    UListKernel best = best_kernel();
+    if (kernel == ULIST_KERNEL_AUTO || kernel > best) {
+        kernel = best;
+    }
+
+    switch (kernel) {
+#ifdef ULIST_X86
+    case ULIST_KERNEL_AVX2:
+        match = match_avx2;
+        break;
+    case ULIST_KERNEL_SSE2:
+        match = match_sse2;
+        break;
+#endif
+    default:
+        kernel = ULIST_KERNEL_SCALAR;
+        match = match_scalar;
+        break;
+    }
+    return kernel;
+}
+
+/**
+ * @brief The kernel in use, picking the default on first use.
+ */
+static match_fn kernel() {
+    if (match == NULL) {
+        ulist_set_kernel(ULIST_KERNEL_AUTO);
+    }
+    return match;
+}
+
+/**
+ * @brief Allocates an empty node from the pool without letting mem_alloc print debug info.
+ *
+ * @param caller Name of the calling function for error messages.
+ * @return Pointer to the new node, or NULL on failure.
+ */
+static UNode* alloc_node(const char* caller) {
+    // Hide stdout to prevent mem_alloc from printing debug info
+    FILE* saved_stdout = redirect_stdout_to_null();
+    if (saved_stdout == NULL) {
+        printf("Error: Failed to redirect stdout in %s.\n", caller);
+        return NULL;
+    }
+
+    // Aligned, so that a node really is one cache line and a search touches one line per node
+    UNode* node = (UNode*)mem_alloc_aligned(sizeof(UNode), sizeof(UNode));
+
+    // Restore stdout after allocation
+    restore_stdout_from_null(saved_stdout);
+
+    if (node == NULL) {
+        printf("Error: Memory allocation failed in %s.\n", caller);
+        return NULL;
+    }
+    node->count = 0;
+    node->next = NULL;
+    return node;
+}
+
+/**
+ * @brief Returns a node to the pool without letting mem_free print debug info.
+ */
+static void free_node(UNode* node) {
+    FILE* saved_stdout = redirect_stdout_to_null();
+    mem_free(node);
+    restore_stdout_from_null(saved_stdout);
+}
+
+/**
+ * @brief Inserts a value so that it ends up at values[index] of the node, splitting a full node.
+ *
+ * @param index Position in the node, 0 to node->count.
+ * @param caller Name of the calling function for error messages.
+ */
+static void insert_at(UList* list, UNode* node, uint16_t index, uint16_t data, const char* caller) {
+    if (node->count == ULIST_CAPACITY) {
+        // Move the upper half into a new node right after this one
+        UNode* upper = alloc_node(caller);
+        if (upper == NULL) {
+            return;
+        }
+        upper->count = ULIST_CAPACITY - SPLIT_AT;
+        memcpy(upper->values, node->values + SPLIT_AT, upper->count * sizeof(uint16_t));
+        node->count = SPLIT_AT;
+        upper->next = node->next;
+        node->next = upper;
+        if (list->tail == node) {
+            list->tail = upper;
+        }
+
+        if (index > SPLIT_AT) {
+            node = upper;
+            index -= SPLIT_AT;
+        }
+    }
+
+    memmove(node->values + index + 1, node->values + index, (node->count - index) * sizeof(uint16_t));
+    node->values[index] = data;
+    node->count++;
+    list->count++;
+}
+
+/**
+ * @brief Moves all values of a node into the node before it and frees it.
+ */
+static void merge_into(UList* list, UNode* node, UNode* next) {
+    memcpy(node->values + node->count, next->values, next->count * sizeof(uint16_t));
+    node->count += next->count;
+    node->next = next->next;
+    if (list->tail == next) {
+        list->tail = node;
+    }
+    free_node(next);
+}
+
+/**
+ * @brief Checks that a position points at a value.
+ */
+static int valid_pos(UListPos pos) {
+    return pos.node != NULL && pos.index < pos.node->count;
+}
+
+/**
+ * @brief Initializes the list and the memory manager.
+ *
+ * @param list Pointer to the list.
+ * @param size Size of the memory pool in bytes.
+ */
+void ulist_init(UList* list, size_t size) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in ulist_init.\n");
+        exit(EXIT_FAILURE); // Can't proceed without a valid list
+    }
+
+    // Temporarily hide stdout to prevent mem_init from printing debug info
+    FILE* saved_stdout = redirect_stdout_to_null();
+    if (saved_stdout == NULL) {
+        printf("Error: Failed to redirect stdout in ulist_init.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    mem_init(size);
+
+    restore_stdout_from_null(saved_stdout);
+
+    list->head = NULL; // Start with an empty list
+    list->tail = NULL;
+    list->count = 0;
+}
+
+/**
+ * @brief Inserts a value at the end of the list.
+ *
+ * A full tail is not split: appends start a new node, so lists built by appending stay packed.
+ *
+ * @param list Pointer to the list.
+ * @param data Value to be inserted.
+ */
+void ulist_insert(UList* list, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in ulist_insert.\n");
+        return;
+    }
+
+    if (list->tail == NULL || list->tail->count == ULIST_CAPACITY) {
+        UNode* node = alloc_node("ulist_insert");
+        if (node == NULL) {
+            return;
+        }
+        if (list->tail == NULL) {
+            list->head = node;
+        } else {
+            list->tail->next = node;
+        }
+        list->tail = node;
+    }
+
+    list->tail->values[list->tail->count++] = data;
+    list->count++;
+}
+
+/**
+ * @brief Inserts a value immediately after the given position.
+ *
+ * @param list Pointer to the list.
+ * @param pos Position after which the value will be inserted.
+ * @param data Value to be inserted.
+ */
+void ulist_insert_after(UList* list, UListPos pos, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in ulist_insert_after.\n");
+        return;
+    }
+
+    if (!valid_pos(pos)) {
+        printf("Error: Invalid position in ulist_insert_after.\n");
+        return;
+    }
+
+    insert_at(list, pos.node, pos.index + 1, data, "ulist_insert_after");
+}
+
+/**
+ * @brief Inserts a value immediately before the given position.
+ *
+ * @param list Pointer to the list.
+ * @param pos Position before which the value will be inserted.
+ * @param data Value to be inserted.
+ */
+void ulist_insert_before(UList* list, UListPos pos, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in ulist_insert_before.\n");
+        return;
+    }
+
+    if (!valid_pos(pos)) {
+        printf("Error: Invalid position in ulist_insert_before.\n");
+        return;
+    }
+
+    insert_at(list, pos.node, pos.index, data, "ulist_insert_before");
+}
+
+/**
+ * @brief Deletes the first occurrence of a value from the list.
+ *
+ * A node left less than half full is merged with a neighbour when their values fit in one node.
+ *
+ * @param list Pointer to the list.
+ * @param data Value to be deleted.
+ */
+void ulist_delete(UList* list, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in ulist_delete.\n");
+        return;
+    }
+
+    if (list->head == NULL) {
+        printf("Error: Cannot delete from an empty list.\n");
+        return;
+    }
+
+    // Search for the value, remembering the node before its node
+    UNode* prev = NULL;
+    UNode* node = list->head;
+    uint16_t index = 0;
+    while (node != NULL) {
+        for (index = 0; index < node->count && node->values[index] != data; index++) {
+        }
+        if (index < node->count) {
+            break;
+        }
+        prev = node;
+        node = node->next;
+    }
+
+    if (node == NULL) {
+        printf("Error: Value %u not found in ulist_delete.\n", data);
+        return;
+    }
+
+    memmove(node->values + index, node->values + index + 1, (node->count - index - 1) * sizeof(uint16_t));
+    node->count--;
+    list->count--;
+
+    if (node->count == 0) {
+        // Unlink the empty node
+        if (prev == NULL) {
+            list->head = node->next;
+        } else {
+            prev->next = node->next;
+        }
+        if (list->tail == node) {
+            list->tail = prev;
+        }
+        free_node(node);
+    } else if (node->count < MERGE_BELOW) {
+        if (node->next != NULL && node->count + node->next->count <= ULIST_CAPACITY) {
+            merge_into(list, node, node->next);
+        } else if (prev != NULL && prev->count + node->count <= ULIST_CAPACITY) {
+            merge_into(list, prev, node);
+        }
+    }
+}
+
+/**
+ * @brief Searches for the first occurrence of a value.
+ *
+ * @param list Pointer to the list.
+ * @param data Value to search for.
+ * @return Position of the value, or a position with a NULL node if not found.
+ */
+UListPos ulist_search(UList* list, uint16_t data) {
+    UListPos pos = {NULL, 0};
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in ulist_search.\n");
+        return pos;
+    }
+
+    // One pointer hop per node; the kernel compares all of its values at once
+    match_fn node_matches = kernel();
+    for (UNode* node = list->head; node != NULL; node = node->next) {
+        uint64_t mask = node_matches(node, data);
+        if (mask != 0) {
+            pos.node = node;
+            pos.index = (uint16_t)(__builtin_ctzll(mask) / 2);
+            return pos; // Found the value
+        }
+    }
+
+    return pos;
+}
+
+/**
+ * @brief Counts the occurrences of a value.
+ *
+ * @param list Pointer to the list.
+ * @param data Value to count.
+ * @return Number of values equal to data.
+ */
+size_t ulist_count_value(UList* list, uint16_t data) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in ulist_count_value.\n");
+        return 0;
+    }
+
+    match_fn node_matches = kernel();
+    size_t count = 0;
+    for (UNode* node = list->head; node != NULL; node = node->next) {
+        count += __builtin_popcountll(node_matches(node, data)) / 2;
+    }
+    return count;
+}
+
+/**
+ * @brief Displays all values in the list.
+ *
+ * @param list Pointer to the list.
+ */
+void ulist_display(UList* list) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in ulist_display.\n");
+        return;
+    }
+
+    UListPos none = {NULL, 0};
+    ulist_display_range(list, none, none);
+}
+
+/**
+ * @brief Displays the values between two positions.
+ *
+ * @param list Pointer to the list.
+ * @param start Starting position (inclusive). If its node is NULL, starts from the head.
+ * @param end Ending position (inclusive). If its node is NULL, ends at the last value.
+ */
+void ulist_display_range(UList* list, UListPos start, UListPos end) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in ulist_display_range.\n");
+        return;
+    }
+
+    printf("[");
+    UNode* node = start.node != NULL ? start.node : list->head;
+    uint16_t index = start.node != NULL ? start.index : 0;
+    int first = 1;
+    for (; node != NULL; node = node->next, index = 0) {
+        for (; index < node->count; index++) {
+            if (!first) {
+                printf(", ");
+            }
+            printf("%u", node->values[index]);
+            first = 0;
+            if (node == end.node && index == end.index) {
+                printf("]"); // Reached the end of the range
+                return;
+            }
+        }
+    }
+    printf("]"); // Consistent output formatting
+}
+
+/**
+ * @brief Counts the values in the list in O(1).
+ *
+ * @param list Pointer to the list.
+ * @return The number of values in the list.
+ */
+size_t ulist_count_values(UList* list) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in ulist_count_values.\n");
+        return 0;
+    }
+
+    return list->count;
+}
+
+/**
+ * @brief Frees all nodes and deinitializes the memory manager.
+ *
+ * @param list Pointer to the list.
+ */
+void ulist_cleanup(UList* list) {
+    if (list == NULL) {
+        printf("Error: list pointer is NULL in ulist_cleanup.\n");
+        return;
+    }
+
+    UNode* current = list->head;
+    while (current != NULL) {
+        UNode* next = current->next;
+        free_node(current);
+        current = next;
+    }
+
+    list->head = NULL; // Reset the list
+    list->tail = NULL;
+    list->count = 0;
+
+    // Finally, deinitialize the memory manager
+    FILE* saved_deinit_stdout = redirect_stdout_to_null();
+    mem_deinit();
+    restore_stdout_from_null(saved_deinit_stdout);
+}
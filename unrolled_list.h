@@ -0,0 +1,158 @@
+#ifndef UNROLLED_LIST_H
+#define UNROLLED_LIST_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define ULIST_CAPACITY 27 // Values per node, so that a node fills one 64-byte cache line
+
+// Node structure for the unrolled list: many values per node, kept in list order
+typedef struct UNode {
+    uint16_t values[ULIST_CAPACITY];
+    uint16_t count;      // Number of values in use, at the front of the array
+    struct UNode* next;  // Pointer to the next node in the list
+} UNode;
+
+// Handle of an unrolled list
+typedef struct {
+    UNode* head;         // First node, NULL for an empty list
+    UNode* tail;         // Last node, NULL for an empty list
+    size_t count;        // Number of values, not nodes
+} UList;
+
+// Position of one value, the unrolled counterpart of a Node pointer.
+// Any insert or delete may move values between nodes, so positions are only
+// valid until the list is changed.
+typedef struct {
+    UNode* node;         // NULL for "no position", e.g. a failed search
+    uint16_t index;      // Index into node->values
+} UListPos;
+
+// Kernels comparing a node's values with a searched value, slowest first
+typedef enum {
+    ULIST_KERNEL_AUTO,   // The fastest one the CPU supports
+    ULIST_KERNEL_SCALAR, // One value at a time
+    ULIST_KERNEL_SSE2,   // 8 values per instruction
+    ULIST_KERNEL_AVX2    // 16 values per instruction
+} UListKernel;
+
+// Initialization function
+/**
+ * @brief Initializes the list and the memory manager.
+ *
+ * @param list Pointer to the list.
+ * @param size Size of the memory pool in bytes.
+ */
+void ulist_init(UList* list, size_t size);
+
+// Value access
+/**
+ * @brief Returns the value at a position.
+ *
+ * @param pos A valid position.
+ * @return The value stored there.
+ */
+static inline uint16_t ulist_value(UListPos pos) {
+    return pos.node->values[pos.index];
+}
+
+// Insertion functions
+/**
+ * @brief Inserts a value at the end of the list.
+ *
+ * @param list Pointer to the list.
+ * @param data Value to be inserted.
+ */
+void ulist_insert(UList* list, uint16_t data);
+
+/**
+ * @brief Inserts a value immediately after the given position.
+ *
+ * @param list Pointer to the list.
+ * @param pos Position after which the value will be inserted.
+ * @param data Value to be inserted.
+ */
+void ulist_insert_after(UList* list, UListPos pos, uint16_t data);
+
+/**
+ * @brief Inserts a value immediately before the given position.
+ *
+ * @param list Pointer to the list.
+ * @param pos Position before which the value will be inserted.
+ * @param data Value to be inserted.
+ */
+void ulist_insert_before(UList* list, UListPos pos, uint16_t data);
+
+// Deletion function
+/**
+ * @brief Deletes the first occurrence of a value from the list.
+ *
+ * @param list Pointer to the list.
+ * @param data Value to be deleted.
+ */
+void ulist_delete(UList* list, uint16_t data);
+
+// Search function
+/**
+ * @brief Searches for the first occurrence of a value.
+ *
+ * @param list Pointer to the list.
+ * @param data Value to search for.
+ * @return Position of the value, or a position with a NULL node if not found.
+ */
+UListPos ulist_search(UList* list, uint16_t data);
+
+/**
+ * @brief Counts the occurrences of a value.
+ *
+ * @param list Pointer to the list.
+ * @param data Value to count.
+ * @return Number of values equal to data.
+ */
+size_t ulist_count_value(UList* list, uint16_t data);
+
+/**
+ * @brief Chooses the kernel used by ulist_search and ulist_count_value.
+ *
+ * The default is ULIST_KERNEL_AUTO. A kernel the CPU lacks is replaced by the fastest one it has.
+ *
+ * @param kernel Kernel to use.
+ * @return The kernel now in use.
+ */
+UListKernel ulist_set_kernel(UListKernel kernel);
+
+// Display functions
+/**
+ * @brief Displays all values in the list.
+ *
+ * @param list Pointer to the list.
+ */
+void ulist_display(UList* list);
+
+/**
+ * @brief Displays the values between two positions.
+ *
+ * @param list Pointer to the list.
+ * @param start Starting position (inclusive). If its node is NULL, starts from the head.
+ * @param end Ending position (inclusive). If its node is NULL, ends at the last value.
+ */
+void ulist_display_range(UList* list, UListPos start, UListPos end);
+
+// Values count function
+/**
+ * @brief Counts the values in the list in O(1).
+ *
+ * @param list Pointer to the list.
+ * @return The number of values in the list.
+ */
+size_t ulist_count_values(UList* list);
+
+// Cleanup function
+/**
+ * @brief Frees all nodes and deinitializes the memory manager.
+ *
+ * @param list Pointer to the list.
+ */
+void ulist_cleanup(UList* list);
+
+#endif // UNROLLED_LIST_H